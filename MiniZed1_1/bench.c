@@ -0,0 +1,458 @@
+/**************************************************************
+ * File: bench.c
+ * Description: Benchmark of the framebuffer mappings, render
+ * throughput and scanout interrupt time of each, of the
+ * decoding of compressed frames, of the pixel throughput of the
+ * drawing primitives and of the scalar and vector kernels.
+ *
+ * Author: Ahac Rafael Bela
+ * Created on: 03.05.2025
+ * Last modified: 16.05.2025
+ *************************************************************/
+
+/*************************************************************
+* Include section
+*************************************************************/
+#include "bench.h"
+#include "vga.h"
+
+/*************************************************************
+* Global variable section
+*************************************************************/
+static const char benchText[] = "The quick brown fox jumps over the lazy dog";
+
+//Offscreen sprite copied to the screen
+static pixel spritePixels[SURFACE_PIXELS(BENCH_SPRITE_SIZE, BENCH_SPRITE_SIZE)] __attribute__((aligned(32)));
+
+//Screen compressed by the compressed frame benchmark
+static rleFrame benchRle;
+static rleRun benchRuns[BENCH_RLE_RUNS];
+static surface sprite;
+
+/*************************************************************
+* Function definition section
+*************************************************************/
+
+/*************************************************************
+* ticksToNs converts global timer ticks to nanoseconds.
+*
+* @param	ticks is the number of ticks.
+*
+* @return	Time in nanoseconds.
+*
+* @note		None.
+*************************************************************/
+static u32 ticksToNs(XTime ticks) {
+	return (u32) (ticks * 1000000000ULL / COUNTS_PER_SECOND);
+}
+
+/*************************************************************
+* drawSprite draws the sprite copied by the benchmark.
+*
+* @param	None.
+*
+* @return	None.
+*
+* @note		Drawn once, every frame only copies it.
+*************************************************************/
+static void drawSprite(void) {
+	initSurface(&sprite, spritePixels, BENCH_SPRITE_SIZE, BENCH_SPRITE_SIZE, SURFACE_PITCH(BENCH_SPRITE_SIZE));
+	fillRows(&sprite, 0, BENCH_SPRITE_SIZE, blue);
+	drawBox(&sprite, (point) {0, 0}, (point) {BENCH_SPRITE_SIZE - 1, BENCH_SPRITE_SIZE - 1}, white);
+	drawText(&sprite, "DMA", (point) {8, 16}, 2, yellow, blue);
+}
+
+/*************************************************************
+* benchmarkRun draws and presents BENCH_FRAMES frames of text,
+* 			lines and sprites with the framebuffers mapped as
+* 			asked, one frame per VSync, and measures the drawing,
+* 			present and the scanout interrupts meanwhile.
+*
+* @param	mapping is the framebuffer mapping to measure.
+* @param	result is where the measurements are stored.
+*
+* @return	None.
+*
+* @note		Draws over the screen, the caller saves and restores it.
+* 			Present should be in mailbox mode, so present measures
+* 			the copy to the next buffer and not the wait for VSync.
+*************************************************************/
+void benchmarkRun(fbMapping mapping, benchResult *result) {
+	u32 flushed;
+	XTime t0, t1;
+
+	memset(result, 0, sizeof(*result));
+	result->mapping = mapping;
+	setFramebufferMapping(mapping);
+	clearSurface(&screenSurface);
+	drawSprite();
+	present();
+	flushed = rowFlushes.flushed;
+	resetIsrStats();
+
+	for(u32 frame = 0; frame < BENCH_FRAMES; frame++) {
+		u32 flips = flipCount;
+
+		XTime_GetTime(&t0);
+		for(u32 i = 0; i < BENCH_TEXTS; i++) {
+			point pos = {0, ((frame * BENCH_TEXTS + i) * CHAR_HEIGHT) % (SCREEN_HEIGHT - CHAR_HEIGHT)};
+			drawText(&screenSurface, benchText, pos, 1, white, black);
+		}
+		XTime_GetTime(&t1);
+		result->textTime += t1 - t0;
+		result->chars += BENCH_TEXTS * (sizeof(benchText) - 1);
+
+		for(u32 i = 0; i < BENCH_LINES; i++) {
+			point start = {0, (frame * BENCH_LINES + i) % SCREEN_HEIGHT};
+			point end = {SCREEN_WIDTH - 1, SCREEN_HEIGHT - 1 - start.y};
+			drawLineB(&screenSurface, start, end, white);
+		}
+		XTime_GetTime(&t0);
+		result->lineTime += t0 - t1;
+		result->lines += BENCH_LINES;
+
+		for(u32 i = 0; i < BENCH_BLITS; i++) {
+			point pos = {(frame * BENCH_BLITS + i) * BENCH_SPRITE_SIZE % (SCREEN_WIDTH - BENCH_SPRITE_SIZE),
+					SCREEN_HEIGHT / 2};
+			blitSurface(&screenSurface, pos, &sprite);
+		}
+		waitFill();
+		XTime_GetTime(&t1);
+		result->blitTime += t1 - t0;
+		result->blits += BENCH_BLITS;
+
+		XTime_GetTime(&t0);
+		present();
+		XTime_GetTime(&t1);
+		result->presentTime += t1 - t0;
+
+		//Every frame is scanned out before the next one is drawn
+		while(flipCount == flips);
+	}
+
+	result->hsync = hsyncStats;
+	result->vsync = vsyncStats;
+	result->rowsFlushed = rowFlushes.flushed - flushed;
+}
+
+/*************************************************************
+* benchmarkPrint prints the measurements of one mapping.
+*
+* @param	result is the measurements to print.
+*
+* @return	None.
+*
+* @note		Times are per call, xil_printf has no floating point.
+*************************************************************/
+static void benchmarkPrint(const benchResult *result) {
+	u32 hsyncAvg = result->hsync.calls ? ticksToNs(result->hsync.totalTime / result->hsync.calls) : 0;
+	u32 vsyncAvg = result->vsync.calls ? ticksToNs(result->vsync.totalTime / result->vsync.calls) : 0;
+
+	xil_printf("%s: drawText %d ns/char, drawLineB %d ns/line, blitSurface %d ns/sprite, present %d us\r\n",
+			result->mapping == FB_MAP_CACHED ? "Cached" : "Non-cacheable",
+			ticksToNs(result->textTime / result->chars), ticksToNs(result->lineTime / result->lines),
+			ticksToNs(result->blitTime / result->blits),
+			ticksToNs(result->presentTime / BENCH_FRAMES) / 1000);
+	xil_printf("  HSync %d ns avg %d ns max, VSync %d ns avg %d ns max, %d rows flushed\r\n",
+			hsyncAvg, ticksToNs(result->hsync.maxTime), vsyncAvg, ticksToNs(result->vsync.maxTime),
+			result->rowsFlushed);
+}
+
+/*************************************************************
+* benchmarkMapping compares the cached framebuffers, flushed row
+* 			by row before scanout, with non-cacheable ones that
+* 			need no cache maintenance, and prints the results.
+*
+* @param	results is where the measurements of each mapping are
+* 			stored, cached first.
+*
+* @return
+* 			- XST_SUCCESS if successful,
+* 			- XST_FAILURE if the screen could not be saved or restored.
+*
+* @note		The mapping and present mode in use are restored.
+*************************************************************/
+int benchmarkMapping(benchResult results[BENCH_MAPPINGS]) {
+	fbMapping previousMapping = getFramebufferMapping();
+	presentMode previousMode = getPresentMode();
+
+	if(saveScreen() != XST_SUCCESS) return XST_FAILURE;
+
+	setPresentMode(PRESENT_MAILBOX);
+	benchmarkRun(FB_MAP_CACHED, &results[0]);
+	benchmarkRun(FB_MAP_NONCACHED, &results[1]);
+	setFramebufferMapping(previousMapping);
+	setPresentMode(previousMode);
+
+	xil_printf("\r\nFramebuffer mapping benchmark, %d frames each\r\n", BENCH_FRAMES);
+	for(u32 i = 0; i < BENCH_MAPPINGS; i++) benchmarkPrint(&results[i]);
+
+	return restoreScreen();
+}
+
+/*************************************************************
+* waitVSync waits for the next VSync.
+*
+* @param	None.
+*
+* @return	None.
+*
+* @note		None.
+*************************************************************/
+static void waitVSync(void) {
+	u32 calls = vsyncStats.calls;
+
+	while(vsyncStats.calls == calls);
+}
+
+/*************************************************************
+* benchmarkRle compresses the screen, shows the compressed frame
+* 			instead of the framebuffers for BENCH_FRAMES frames
+* 			and prints its size and the cost of decoding it.
+*
+* @param	result is where the measurements are stored.
+*
+* @return
+* 			- XST_SUCCESS if successful,
+* 			- XST_FAILURE if the screen does not compress into
+* 			  BENCH_RLE_RUNS runs or the DMA is in SG mode.
+*
+* @note		The decode time per line is spent in HSyncIntrHandler
+* 			in place of the flush of a framebuffer row, compare it
+* 			with the HSync times of the mapping benchmark. Lines
+* 			showing the row of the line before are sent again
+* 			without decoding.
+*************************************************************/
+int benchmarkRle(rleBenchResult *result) {
+	memset(result, 0, sizeof(*result));
+	//The draw buffer holds a copy of the frame on screen
+	waitFill();
+	if(rleEncode(&benchRle, &screenSurface, benchRuns, BENCH_RLE_RUNS) != XST_SUCCESS ||
+			showRleFrame(&benchRle) != XST_SUCCESS) {
+		xil_printf("\r\nThe screen can not be shown compressed\r\n");
+		return XST_FAILURE;
+	}
+	result->runs = benchRle.runCount;
+	result->bytes = rleFrameBytes(&benchRle);
+
+	//Measure whole frames of the compressed screen
+	waitVSync();
+	resetRleStats();
+	resetIsrStats();
+	for(u32 frame = 0; frame < BENCH_FRAMES; frame++) waitVSync();
+	result->decode = rleDecodeStats;
+	result->hsync = hsyncStats;
+	showRleFrame(NULL);
+	waitVSync();
+
+	xil_printf("\r\nCompressed frame benchmark, %d frames\r\n", BENCH_FRAMES);
+	xil_printf("%d runs, %d bytes for a %d byte framebuffer\r\n", result->runs, result->bytes, FB_SIZE);
+	xil_printf("  decode %d ns/line avg %d ns max, %d lines decoded, %d sent again\r\n",
+			result->decode.decoded ? ticksToNs(result->decode.totalTime / result->decode.decoded) : 0,
+			ticksToNs(result->decode.maxTime), result->decode.decoded, result->decode.resent);
+	xil_printf("  HSync %d ns avg %d ns max\r\n",
+			result->hsync.calls ? ticksToNs(result->hsync.totalTime / result->hsync.calls) : 0,
+			ticksToNs(result->hsync.maxTime));
+
+	return XST_SUCCESS;
+}
+
+/*************************************************************
+* mpixelsPerSecond converts a number of pixels drawn in a time
+* 			to a throughput.
+*
+* @param	pixels is the number of pixels.
+* @param	ticks is the time in global timer ticks.
+*
+* @return	Throughput in tenths of Mpixels/s.
+*
+* @note		None.
+*************************************************************/
+static u32 mpixelsPerSecond(u32 pixels, XTime ticks) {
+	return ticks ? (u32) ((u64) pixels * COUNTS_PER_SECOND / 100000 / ticks) : 0;
+}
+
+/*************************************************************
+* benchmarkSpans covers the draw buffer BENCH_SPAN_PASSES times
+* 			with rows drawn pixel by pixel, with rows drawn by
+* 			hspan, with columns drawn by vspan, with text and with
+* 			mostly horizontal lines, and prints the throughput of
+* 			each.
+*
+* @param	result is where the measurements are stored.
+*
+* @return
+* 			- XST_SUCCESS if successful,
+* 			- XST_FAILURE if the screen could not be saved or restored.
+*
+* @note		The rows drawn by putPixel are how the primitives drew
+* 			before the span layer, one call and one store per pixel.
+* 			The lines rise a row every BENCH_LINE_SLOPE columns,
+* 			drawLineB draws them as runs that long. The text starts
+* 			from an empty glyph cache, its hit rate is printed too.
+*************************************************************/
+int benchmarkSpans(spanBenchResult *result) {
+	colors passColors[BENCH_SPAN_PASSES] = {blue, green, red, gray};
+	XTime t0, t1;
+
+	if(saveScreen() != XST_SUCCESS) return XST_FAILURE;
+	memset(result, 0, sizeof(*result));
+	result->pixels = BENCH_SPAN_PASSES * SCREEN_WIDTH * SCREEN_HEIGHT;
+
+	XTime_GetTime(&t0);
+	for(u32 pass = 0; pass < BENCH_SPAN_PASSES; pass++) {
+		for(s32 y = 0; y < SCREEN_HEIGHT; y++) {
+			for(s32 x = 0; x < SCREEN_WIDTH; x++) putPixel(&screenSurface, (point) {x, y}, passColors[pass]);
+		}
+	}
+	XTime_GetTime(&t1);
+	result->pixelTime = t1 - t0;
+
+	for(u32 pass = 0; pass < BENCH_SPAN_PASSES; pass++) {
+		for(s32 y = 0; y < SCREEN_HEIGHT; y++) hspan(&screenSurface, y, 0, SCREEN_WIDTH - 1, passColors[pass]);
+	}
+	XTime_GetTime(&t0);
+	result->hspanTime = t0 - t1;
+
+	for(u32 pass = 0; pass < BENCH_SPAN_PASSES; pass++) {
+		for(s32 x = 0; x < SCREEN_WIDTH; x++) vspan(&screenSurface, x, 0, SCREEN_HEIGHT - 1, passColors[pass]);
+	}
+	XTime_GetTime(&t1);
+	result->vspanTime = t1 - t0;
+
+	//The text starts with an empty glyph cache, its misses are part of the time
+	flushGlyphCache();
+	resetGlyphCacheStats();
+	for(u32 pass = 0; pass < BENCH_SPAN_PASSES; pass++) {
+		for(s32 y = 0; y + CHAR_HEIGHT <= SCREEN_HEIGHT; y += CHAR_HEIGHT) {
+			drawText(&screenSurface, benchText, (point) {0, y}, 1, white, passColors[pass]);
+			result->textPixels += (sizeof(benchText) - 1) * CHAR_WIDTH * CHAR_HEIGHT;
+		}
+	}
+	XTime_GetTime(&t0);
+	result->textTime = t0 - t1;
+	result->glyphs = glyphStats;
+
+	for(u32 pass = 0; pass < BENCH_SPAN_PASSES; pass++) {
+		for(s32 y = 0; y + SCREEN_WIDTH / BENCH_LINE_SLOPE < SCREEN_HEIGHT; y++) {
+			drawLineB(&screenSurface, (point) {0, y}, (point) {SCREEN_WIDTH - 1, y + SCREEN_WIDTH / BENCH_LINE_SLOPE}, passColors[pass]);
+			result->linePixels += SCREEN_WIDTH;
+		}
+	}
+	XTime_GetTime(&t1);
+	result->lineTime = t1 - t0;
+
+	xil_printf("\r\nPixel throughput benchmark, %d pixels each\r\n", result->pixels);
+	u32 rates[] = {mpixelsPerSecond(result->pixels, result->pixelTime), mpixelsPerSecond(result->pixels, result->hspanTime),
+			mpixelsPerSecond(result->pixels, result->vspanTime), mpixelsPerSecond(result->textPixels, result->textTime),
+			mpixelsPerSecond(result->linePixels, result->lineTime)};
+	xil_printf("  putPixel %d.%d, hspan %d.%d, vspan %d.%d, drawText %d.%d, drawLineB %d.%d Mpixels/s\r\n",
+			rates[0] / 10, rates[0] % 10, rates[1] / 10, rates[1] % 10,
+			rates[2] / 10, rates[2] % 10, rates[3] / 10, rates[3] % 10, rates[4] / 10, rates[4] % 10);
+	u32 hitRate = glyphCacheHitRate();
+	xil_printf("  glyph cache %d hits, %d misses, %d evictions, %d.%d%% hit rate\r\n",
+			result->glyphs.hits, result->glyphs.misses, result->glyphs.evictions, hitRate / 10, hitRate % 10);
+
+	return restoreScreen();
+}
+
+/*************************************************************
+* benchmarkKernelPath fills, copies and draws text over the draw
+* 			buffer BENCH_SPAN_PASSES times with one kernel path.
+*
+* @param	result is where the measurements are stored, its path
+* 			selects the kernels.
+*
+* @return	None.
+*
+* @note		The rows are filled and copied by the kernels directly,
+* 			the top half of the screen over the bottom half.
+*************************************************************/
+static void benchmarkKernelPath(kernelBenchResult *result) {
+	colors passColors[BENCH_SPAN_PASSES] = {blue, green, red, gray};
+	u32 words = FB_LINE_BYTES / 4;
+	u32 half = SCREEN_HEIGHT / 2;
+	XTime t0, t1;
+
+	setKernelPath(result->path);
+	result->bytes = BENCH_SPAN_PASSES * half * FB_LINE_BYTES;
+	waitFill();
+	//Every path starts at the same point of a frame, so the scanout interrupts hit them alike
+	waitVSync();
+
+	XTime_GetTime(&t0);
+	for(u32 pass = 0; pass < BENCH_SPAN_PASSES; pass++) {
+		//The pixel repeated over a word
+		u32 value = COLOR_TO_PIXEL(passColors[pass]) * (u32) (0xFFFFFFFFULL / ((1ULL << FB_BITS_PER_PIXEL) - 1));
+
+		for(u32 y = 0; y < half; y++) fillWords((u32 *) SURFACE_ROW(&screenSurface, y), value, words);
+	}
+	XTime_GetTime(&t1);
+	result->fillTime = t1 - t0;
+
+	for(u32 pass = 0; pass < BENCH_SPAN_PASSES; pass++) {
+		for(u32 y = 0; y < half; y++) {
+			copyWords((u32 *) SURFACE_ROW(&screenSurface, half + y), (const u32 *) SURFACE_ROW(&screenSurface, y), words);
+		}
+	}
+	XTime_GetTime(&t0);
+	result->copyTime = t0 - t1;
+	markRowsDirty(0, SCREEN_HEIGHT);
+
+	for(u32 pass = 0; pass < BENCH_SPAN_PASSES; pass++) {
+		for(s32 y = 0; y + CHAR_HEIGHT <= SCREEN_HEIGHT; y += CHAR_HEIGHT) {
+			drawText(&screenSurface, benchText, (point) {0, y}, 1, white, passColors[pass]);
+			result->textPixels += (sizeof(benchText) - 1) * CHAR_WIDTH * CHAR_HEIGHT;
+		}
+	}
+	XTime_GetTime(&t1);
+	result->textTime = t1 - t0;
+}
+
+/*************************************************************
+* benchmarkKernels compares the scalar kernels with the vector
+* 			ones and prints the results.
+*
+* @param	results is where the measurements of each path are
+* 			stored, scalar first.
+*
+* @return
+* 			- XST_SUCCESS if successful,
+* 			- XST_FAILURE if the screen could not be saved or restored.
+*
+* @note		The vector path is left out if it is not built. The
+* 			kernel path in use is restored. drawText goes through
+* 			the two-color expand kernel with XRGB8888 framebuffers
+* 			and through the fill kernel otherwise.
+*************************************************************/
+int benchmarkKernels(kernelBenchResult results[BENCH_KERNEL_PATHS]) {
+	kernelPath previousPath = getKernelPath();
+	u32 paths = KERNELS_HAVE_VECTOR ? BENCH_KERNEL_PATHS : 1;
+
+	if(saveScreen() != XST_SUCCESS) return XST_FAILURE;
+	memset(results, 0, BENCH_KERNEL_PATHS * sizeof(results[0]));
+
+	for(u32 i = 0; i < paths; i++) {
+		results[i].path = (i == 0) ? KERNELS_SCALAR : KERNELS_VECTOR;
+		benchmarkKernelPath(&results[i]);
+	}
+	setKernelPath(previousPath);
+
+	xil_printf("\r\nKernel benchmark, %d bytes filled and copied each\r\n", results[0].bytes);
+	for(u32 i = 0; i < paths; i++) {
+		const kernelBenchResult *result = &results[i];
+		u32 text = mpixelsPerSecond(result->textPixels, result->textTime);
+
+		xil_printf("%s: fill %d MB/s, copy %d MB/s, drawText %d.%d Mpixels/s\r\n",
+				result->path == KERNELS_VECTOR ? "Vector" : "Scalar",
+				mpixelsPerSecond(result->bytes, result->fillTime) / 10,
+				mpixelsPerSecond(result->bytes, result->copyTime) / 10, text / 10, text % 10);
+	}
+	if(paths == 1) xil_printf("Vector kernels not built, compile with -mfpu=neon\r\n");
+
+	return restoreScreen();
+}
+
+/*************************************************************
+* End of file
+*************************************************************/
@@ -0,0 +1,111 @@
+/**************************************************************
+ * File: bench.h
+ * Description: Benchmark of the framebuffer mappings, render
+ * throughput and scanout interrupt time of each, of the
+ * decoding of compressed frames, of the pixel throughput of the
+ * drawing primitives and of the scalar and vector kernels.
+ *
+ * Author: Ahac Rafael Bela
+ * Created on: 03.05.2025
+ * Last modified: 16.05.2025
+ *************************************************************/
+//Protection macro
+#pragma once
+#ifndef BENCH_H
+#define BENCH_H
+
+/*************************************************************
+* Include section
+*************************************************************/
+#include "libs.h"
+#include "framebuffer.h"
+#include "rle.h"
+#include "kernels.h"
+#include "glyphcache.h"
+
+/*************************************************************
+* Macro section
+*************************************************************/
+//Frames drawn and presented for each mapping
+#define BENCH_FRAMES		30
+//Text lines and lines drawn in each frame
+#define BENCH_TEXTS			4
+#define BENCH_LINES			16
+//Copies of an offscreen sprite of BENCH_SPRITE_SIZE x BENCH_SPRITE_SIZE pixels drawn in each frame
+#define BENCH_BLITS			8
+#define BENCH_SPRITE_SIZE	64
+//Number of mappings compared
+#define BENCH_MAPPINGS		2
+//Runs the screen may be compressed to, 64 KB
+#define BENCH_RLE_RUNS		8192
+//Times the screen is covered by each drawing primitive
+#define BENCH_SPAN_PASSES	4
+//Columns the lines of the span benchmark take per row they rise, mostly horizontal lines
+#define BENCH_LINE_SLOPE	8
+//Kernel paths compared, scalar and vector
+#define BENCH_KERNEL_PATHS	2
+
+/*************************************************************
+* Struct section
+*************************************************************/
+typedef struct benchResult_t {
+	fbMapping mapping;		//Mapping the result was measured with
+	u32 chars;				//Characters drawn by drawText
+	XTime textTime;			//Time spent in drawText in global timer ticks
+	u32 lines;				//Lines drawn by drawLineB
+	XTime lineTime;			//Time spent in drawLineB in global timer ticks
+	u32 blits;				//Sprites copied by blitSurface
+	XTime blitTime;			//Time spent in blitSurface, until the copies are done, in global timer ticks
+	XTime presentTime;		//Time spent in present in global timer ticks
+	isrStats hsync;			//HSyncIntrHandler timings over the frames
+	isrStats vsync;			//VSyncIntrHandler timings over the frames
+	u32 rowsFlushed;		//Rows flushed before they were scanned out
+} benchResult;
+
+typedef struct rleBenchResult_t {
+	u32 runs;				//Runs the screen was compressed to
+	u32 bytes;				//Bytes of the compressed screen
+	rleStats decode;		//Decode timings over the frames
+	isrStats hsync;			//HSyncIntrHandler timings over the frames
+} rleBenchResult;
+
+typedef struct spanBenchResult_t {
+	u32 pixels;				//Pixels drawn by putPixel, hspan and vspan each
+	XTime pixelTime;		//Time spent drawing the rows pixel by pixel with putPixel in global timer ticks
+	XTime hspanTime;		//Time spent drawing the rows with hspan
+	XTime vspanTime;		//Time spent drawing the columns with vspan
+	u32 textPixels;			//Pixels drawn by drawText
+	XTime textTime;			//Time spent in drawText
+	glyphCacheStats glyphs;	//Glyph cache lookups of drawText, from an empty cache
+	u32 linePixels;			//Pixels drawn by drawLineB
+	XTime lineTime;			//Time spent in drawLineB
+} spanBenchResult;
+
+typedef struct kernelBenchResult_t {
+	kernelPath path;		//Kernels the result was measured with
+	u32 bytes;				//Bytes filled and copied each
+	XTime fillTime;			//Time spent filling rows with fillWords in global timer ticks
+	XTime copyTime;			//Time spent copying rows with copyWords
+	u32 textPixels;			//Pixels drawn by drawText, copied from the glyph cache by copyWords
+	XTime textTime;			//Time spent in drawText
+} kernelBenchResult;
+
+/*************************************************************
+* Function prototype section
+*************************************************************/
+//Measures one framebuffer mapping.
+void benchmarkRun(fbMapping mapping, benchResult *result);
+//Compares the cached and non-cacheable mappings and prints the results.
+int benchmarkMapping(benchResult results[BENCH_MAPPINGS]);
+//Shows the screen compressed for a number of frames and prints the decode cost.
+int benchmarkRle(rleBenchResult *result);
+//Measures the pixel throughput of the drawing primitives and prints the results.
+int benchmarkSpans(spanBenchResult *result);
+//Compares the scalar and vector kernels and prints the results.
+int benchmarkKernels(kernelBenchResult results[BENCH_KERNEL_PATHS]);
+
+#endif /* BENCH_H */
+
+/*************************************************************
+* End of file
+*************************************************************/
@@ -0,0 +1,180 @@
+/**************************************************************
+ * File: display.c
+ * Description: Table of the display modes the VGA output can
+ * show and the selection of one at runtime.
+ *
+ * Author: Ahac Rafael Bela
+ * Created on: 06.05.2025
+ * Last modified: 17.05.2025
+ *************************************************************/
+
+/*************************************************************
+* Include section
+*************************************************************/
+#include "display.h"
+#include "framebuffer.h"
+#include "vga.h"
+
+/*************************************************************
+* Global variable section
+*************************************************************/
+//VESA timings, none may be larger than SCREEN_MAX_WIDTH x SCREEN_MAX_HEIGHT, visible or in the framebuffer.
+//Pixel-doubled modes have the timing of the mode twice their size, the scanout repeats each
+//pixel into a line buffer and sends it for each of the repeated lines.
+const displayMode displayModes[DISPLAY_MODES] = {
+	[DISPLAY_640X480] = {"640x480@60", 640, 480, 1, 25175000, 16, 96, 48, 10, 2, 33, DISPLAY_PITCH(640), FB_FORMAT},
+	[DISPLAY_800X600] = {"800x600@60", 800, 600, 1, 40000000, 40, 128, 88, 1, 4, 23, DISPLAY_PITCH(800), FB_FORMAT},
+	[DISPLAY_400X300] = {"400x300@60", 400, 300, 2, 40000000, 40, 128, 88, 1, 4, 23, DISPLAY_PITCH(400), FB_FORMAT}
+};
+
+//Mode the scanout and the drawing code use
+const displayMode *currentMode = &displayModes[DISPLAY_MODE];
+
+/*************************************************************
+* Function definition section
+*************************************************************/
+
+/*************************************************************
+* timingAvailable checks if the hardware can generate the timing
+* 			of a display mode.
+*
+* @param	mode is the display mode.
+*
+* @return
+* 			- 1 if the mode can be shown,
+* 			- 0 otherwise.
+*
+* @note		Without the mode select (DISPLAY_MODE_SEL_ADDR) only
+* 			modes with the timing of DISPLAY_MODE can be shown.
+* 			Pixel-doubled modes need the DMA in simple mode, the
+* 			SG engine sends the rows as they are.
+*************************************************************/
+static int timingAvailable(const displayMode *mode) {
+	if(mode->scale > 1 && XAxiDma_HasSg(ctrls->AxiDma)) return 0;
+#ifdef DISPLAY_MODE_SEL_ADDR
+	return 1;
+#else
+	const displayMode *boot = &displayModes[DISPLAY_MODE];
+
+	return mode->pixelClock == boot->pixelClock &&
+			DISPLAY_H_TOTAL(mode) == DISPLAY_H_TOTAL(boot) && DISPLAY_V_TOTAL(mode) == DISPLAY_V_TOTAL(boot) &&
+			DISPLAY_V_BLANK(mode) == DISPLAY_V_BLANK(boot);
+#endif
+}
+
+/*************************************************************
+* initDisplay selects the timing of the boot display mode, sets
+* 			the row tables and the geometry of the screen surface.
+*
+* @param	None.
+*
+* @return	None.
+*
+* @note		Called from initPlatform before the first VSync.
+*************************************************************/
+void initDisplay(void) {
+#ifdef DISPLAY_MODE_SEL_ADDR
+	Xil_Out32(DISPLAY_MODE_SEL_ADDR, DISPLAY_MODE);
+#endif
+	initLineRows();
+	updateScreenSurface();
+	xil_printf("Display mode %s\r\n", currentMode->name);
+}
+
+/*************************************************************
+* setDisplayMode switches the scanout and the drawing code to
+* 			another display mode.
+*
+* @param	id is the display mode to use.
+*
+* @return
+* 			- XST_SUCCESS if successful,
+* 			- XST_FAILURE if the mode is unknown, has another pixel
+* 			format or its timing can not be generated.
+*
+* @note		All framebuffers are cleared to black (index 0) and the
+* 			scanout starts over with the next VSync, the caller
+* 			draws the screen again. HSync and VSync are disabled
+* 			while the geometry changes.
+*************************************************************/
+int setDisplayMode(displayModeId id) {
+	const displayMode *mode;
+	int Status;
+
+	if(id >= DISPLAY_MODES) return XST_FAILURE;
+	mode = &displayModes[id];
+	if(mode == currentMode) return XST_SUCCESS;
+	//The pixel type is fixed when building, so is the format of the VGA output
+	if(mode->format != FB_FORMAT || !timingAvailable(mode)) return XST_FAILURE;
+
+	//Fills and copies must not run on the old geometry
+	waitFill();
+	XScuGic_Disable(ctrls->IntcInstancePtr, HSYNC_INTR_ID);
+	XScuGic_Disable(ctrls->IntcInstancePtr, VSYNC_INTR_ID);
+
+	currentMode = mode;
+#ifdef DISPLAY_MODE_SEL_ADDR
+	Xil_Out32(DISPLAY_MODE_SEL_ADDR, id);
+#endif
+	//Rows drawn with the old pitch are meaningless now
+	resetFramebuffers();
+	Status = restartScanout(ctrls);
+
+	XScuGic_Enable(ctrls->IntcInstancePtr, VSYNC_INTR_ID);
+	XScuGic_Enable(ctrls->IntcInstancePtr, HSYNC_INTR_ID);
+	xil_printf("Display mode %s\r\n", currentMode->name);
+
+	return Status;
+}
+
+/*************************************************************
+* getDisplayMode returns the selected display mode.
+*
+* @param	None.
+*
+* @return	The current display mode.
+*
+* @note		None.
+*************************************************************/
+displayModeId getDisplayMode(void) {
+	return (displayModeId) (currentMode - displayModes);
+}
+
+/*************************************************************
+* findDisplayMode finds the cheapest display mode a screen of
+* 			width x height pixels fits in.
+*
+* @param	width is the least number of visible pixels per line.
+* @param	height is the least number of visible lines.
+*
+* @return
+* 			- the display mode with the fewest framebuffer pixels,
+* 			  the lower pixel clock on a tie,
+* 			- -1 if no mode that can be shown is large enough.
+*
+* @note		None.
+*************************************************************/
+s32 findDisplayMode(u32 width, u32 height) {
+	s32 best = -1;
+
+	for(s32 i = 0; i < DISPLAY_MODES; i++) {
+		const displayMode *mode = &displayModes[i];
+
+		if(mode->width < width || mode->height < height) continue;
+		if(mode->format != FB_FORMAT || !timingAvailable(mode)) continue;
+		if(best >= 0) {
+			u32 pixels = mode->width * mode->height;
+			u32 bestPixels = displayModes[best].width * displayModes[best].height;
+
+			if(pixels > bestPixels) continue;
+			if(pixels == bestPixels && mode->pixelClock >= displayModes[best].pixelClock) continue;
+		}
+		best = i;
+	}
+
+	return best;
+}
+
+/*************************************************************
+* End of file
+*************************************************************/
@@ -0,0 +1,69 @@
+/**************************************************************
+ * File: display.h
+ * Description: Table of the display modes the VGA output can
+ * show and the selection of one at runtime.
+ *
+ * Author: Ahac Rafael Bela
+ * Created on: 06.05.2025
+ * Last modified: 08.05.2025
+ *************************************************************/
+//Protection macro
+#pragma once
+#ifndef DISPLAY_H
+#define DISPLAY_H
+
+/*************************************************************
+* Include section
+*************************************************************/
+#include "libs.h"
+
+/*************************************************************
+* Macro section
+*************************************************************/
+//Display mode selected on startup
+#ifndef DISPLAY_MODE
+#define DISPLAY_MODE		DISPLAY_800X600
+#endif
+//Visible pixel clocks per line and visible lines per frame, the framebuffer size times the pixel repeat
+#define DISPLAY_ACTIVE_WIDTH(m)		((m)->width * (m)->scale)
+#define DISPLAY_ACTIVE_HEIGHT(m)	((m)->height * (m)->scale)
+//Pixel clocks per line and lines per frame, porches and sync pulses included
+#define DISPLAY_H_TOTAL(m)	(DISPLAY_ACTIVE_WIDTH(m) + (m)->hFrontPorch + (m)->hSync + (m)->hBackPorch)
+#define DISPLAY_V_TOTAL(m)	(DISPLAY_ACTIVE_HEIGHT(m) + (m)->vFrontPorch + (m)->vSync + (m)->vBackPorch)
+//Lines from VSync, raised at the end of the visible frame, to the first visible line
+#define DISPLAY_V_BLANK(m)	((m)->vFrontPorch + (m)->vSync + (m)->vBackPorch)
+//Framebuffer pitch of a mode width pixels wide
+#define DISPLAY_PITCH(width)	FB_PITCH_FOR((width) * FB_BITS_PER_PIXEL / 8)
+
+/*************************************************************
+* Enum section
+*************************************************************/
+typedef enum displayModeId_t {
+	DISPLAY_640X480,	//640x480@60, 25.175 MHz
+	DISPLAY_800X600,	//800x600@60, 40 MHz
+	DISPLAY_400X300,	//800x600@60 timing with every pixel doubled
+	DISPLAY_MODES		//Number of display modes
+} displayModeId;
+
+/*************************************************************
+* Variable declaration section
+*************************************************************/
+extern const displayMode displayModes[DISPLAY_MODES];
+
+/*************************************************************
+* Function prototype section
+*************************************************************/
+//Selects the timing of the boot display mode.
+void initDisplay(void);
+//Switches the scanout and the drawing code to another display mode.
+int setDisplayMode(displayModeId id);
+//Returns the selected display mode.
+displayModeId getDisplayMode(void);
+//Finds the cheapest display mode a width x height screen fits in.
+s32 findDisplayMode(u32 width, u32 height);
+
+#endif /* DISPLAY_H */
+
+/*************************************************************
+* End of file
+*************************************************************/
@@ -0,0 +1,241 @@
+/**************************************************************
+ * File: dmaqueue.c
+ * Description: Asynchronous DMA job queue with completion
+ * callbacks, shared with the scanout on the MM2S channel.
+ *
+ * Author: Ahac Rafael Bela
+ * Created on: 25.04.2025
+ * Last modified: 17.05.2025
+ *************************************************************/
+
+/*************************************************************
+* Include section
+*************************************************************/
+#include "dmaqueue.h"
+
+/*************************************************************
+* Struct section
+*************************************************************/
+//Single producer (main context), single consumer (DMA interrupt) ring
+typedef struct dmaRing_t {
+	dmaJob jobs[DMA_QUEUE_SIZE];
+	volatile u32 head;		//Written only by dmaQueueSubmit
+	volatile u32 tail;		//Written only by dmaQueuePop
+} dmaRing;
+
+/*************************************************************
+* Global variable section
+*************************************************************/
+static dmaRing queues[DMA_PRIO_COUNT];
+static volatile dmaQueueStats queueStats;
+//Job being transferred, kept until dmaQueueFinish
+static dmaJob activeJob;
+
+/*************************************************************
+* Function definition section
+*************************************************************/
+
+/*************************************************************
+* waitingJobs counts the jobs waiting in all queues.
+*
+* @param	None.
+*
+* @return	Number of queued jobs not yet taken by dmaQueuePop.
+*
+* @note		The job being transferred is not counted.
+*************************************************************/
+static u32 waitingJobs(void) {
+	u32 depth = 0;
+
+	for(u32 p = 0; p < DMA_PRIO_COUNT; p++) depth += queues[p].head - queues[p].tail;
+
+	return depth;
+}
+
+/*************************************************************
+* dmaQueueSubmit copies a job into the queue of its priority and
+* 			starts the channel if it is idle.
+*
+* @param	job is the job to queue.
+*
+* @return
+* 			- XST_SUCCESS if the job was queued,
+* 			- XST_FAILURE if the queue is full or the job is invalid.
+*
+* @note		Must be called from the main context only, the queue is
+* 			lock-free with one producer and one consumer. Callbacks
+* 			run in interrupt context and must not submit jobs.
+*************************************************************/
+int dmaQueueSubmit(const dmaJob *job) {
+	if(job->priority >= DMA_PRIO_COUNT || job->length == 0 || job->length > DMA_MAX_LENGTH) return XST_FAILURE;
+	//Memory destinations need the S2MM channel, in SG mode the queue is not serviced
+	if((job->dst && !ctrls->CfgPtr->HasS2Mm) || XAxiDma_HasSg(ctrls->AxiDma)) return XST_FAILURE;
+
+	dmaRing *ring = &queues[job->priority];
+	u32 head = ring->head;
+
+	if(head - ring->tail == DMA_QUEUE_SIZE) {
+		queueStats.rejected++;
+		return XST_FAILURE;
+	}
+	//The source must be in DDR before the DMA reads it and no dirty
+	//destination line may be written back over the copied data
+	if(!(job->flags & DMA_FLAG_NO_FLUSH)) {
+		Xil_DCacheFlushRange((INTPTR) job->src, job->length);
+		if(job->dst) Xil_DCacheFlushRange((INTPTR) job->dst, job->length);
+	}
+
+	ring->jobs[head % DMA_QUEUE_SIZE] = *job;
+	//The job must be in memory before the consumer can see it
+	__sync_synchronize();
+	ring->head = head + 1;
+
+	queueStats.submitted++;
+	//Counted like depth, before an idle channel takes the job
+	u32 depth = waitingJobs();
+	if(depth > queueStats.maxDepth) queueStats.maxDepth = depth;
+
+	dmaKick(ctrls);
+
+	return XST_SUCCESS;
+}
+
+/*************************************************************
+* dmaCopyAsync copies memory using the MM2S and S2MM channels as
+* 			a hardware memcpy engine, so the CPU is free while the
+* 			copy runs. Copies longer than DMA_MAX_LENGTH are split.
+*
+* @param	dst is the destination address.
+* @param	src is the source address.
+* @param	length is the number of bytes to copy.
+* @param	callback is called from the interrupt once the whole
+* 			copy is done, may be NULL.
+* @param	callbackRef is the argument passed to the callback.
+*
+* @return
+* 			- XST_SUCCESS if the copy was queued,
+* 			- XST_FAILURE if the queue could not take all of it,
+* 			then no part of it was queued.
+*
+* @note		Scanout lines go in between the DMA_JOB_SLICE byte
+* 			slices of a copy, as the MM2S stream is looped back
+* 			to S2MM while a slice runs. Room for all parts is
+* 			checked first, free slots only grow until the next
+* 			submit, so a copy never loses the part with the
+* 			callback.
+*************************************************************/
+int dmaCopyAsync(u32 *dst, u32 *src, u32 length, dmaCallback callback, void *callbackRef) {
+	dmaJob job = {src, dst, 0, DMA_PRIO_NORMAL, NULL, NULL, 0};
+	u32 partLength = DMA_MAX_LENGTH & ~3U;
+	u32 parts = length / partLength + (length % partLength != 0);
+
+	if(parts > dmaQueueFree(DMA_PRIO_NORMAL)) {
+		queueStats.rejected++;
+		return XST_FAILURE;
+	}
+	while(length) {
+		job.length = (length > partLength) ? partLength : length;
+		length -= job.length;
+		//Only the last part reports the completion
+		if(length == 0) {
+			job.callback = callback;
+			job.callbackRef = callbackRef;
+		}
+		if(dmaQueueSubmit(&job) != XST_SUCCESS) return XST_FAILURE;
+		job.src = (u32 *) ((u8 *) job.src + job.length);
+		job.dst = (u32 *) ((u8 *) job.dst + job.length);
+	}
+	return XST_SUCCESS;
+}
+
+/*************************************************************
+* dmaQueueFree returns the number of jobs a queue can still take.
+*
+* @param	priority is the queue to check.
+*
+* @return	Number of free slots.
+*
+* @note		Free slots only grow until the next dmaQueueSubmit.
+*************************************************************/
+u32 dmaQueueFree(dmaPriority priority) {
+	return DMA_QUEUE_SIZE - (queues[priority].head - queues[priority].tail);
+}
+
+/*************************************************************
+* dmaQueuePop takes the next job, highest priority first.
+*
+* @param	None.
+*
+* @return
+* 			- pointer to the job, valid until dmaQueueFinish,
+* 			- NULL if all queues are empty.
+*
+* @note		Called only with the DMA completion interrupt masked
+* 			or from inside it.
+*************************************************************/
+dmaJob *dmaQueuePop(void) {
+	for(u32 p = 0; p < DMA_PRIO_COUNT; p++) {
+		dmaRing *ring = &queues[p];
+		u32 tail = ring->tail;
+
+		if(tail != ring->head) {
+			activeJob = ring->jobs[tail % DMA_QUEUE_SIZE];
+			__sync_synchronize();
+			ring->tail = tail + 1;
+			return &activeJob;
+		}
+	}
+	return NULL;
+}
+
+/*************************************************************
+* dmaQueueFinish updates the counters for a finished job and
+* 			calls its callback.
+*
+* @param	job is the job returned by dmaQueuePop.
+* @param	duration is the transfer time in global timer ticks.
+* @param	status is XST_SUCCESS or XST_FAILURE.
+*
+* @return	None.
+*
+* @note		Called from the DMA completion interrupt.
+*************************************************************/
+void dmaQueueFinish(dmaJob *job, XTime duration, int status) {
+	queueStats.completed++;
+	queueStats.bytes += job->length;
+	queueStats.busyTime += duration;
+
+	if(job->callback) job->callback(job->callbackRef, status);
+}
+
+/*************************************************************
+* dmaQueueGetStats copies the queue counters.
+*
+* @param	stats is where to copy the counters to.
+*
+* @return	None.
+*
+* @note		None.
+*************************************************************/
+void dmaQueueGetStats(dmaQueueStats *stats) {
+	*stats = queueStats;
+	stats->depth = waitingJobs();
+}
+
+/*************************************************************
+* dmaQueueThroughput calculates the transfer rate of finished jobs.
+*
+* @param	None.
+*
+* @return	Bytes per second while the channel was busy with jobs.
+*
+* @note		None.
+*************************************************************/
+u32 dmaQueueThroughput(void) {
+	if(queueStats.busyTime == 0) return 0;
+	return (u32) (queueStats.bytes * COUNTS_PER_SECOND / queueStats.busyTime);
+}
+
+/*************************************************************
+* End of file
+*************************************************************/
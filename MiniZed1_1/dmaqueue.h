@@ -0,0 +1,88 @@
+/**************************************************************
+ * File: dmaqueue.h
+ * Description: Asynchronous DMA job queue with completion
+ * callbacks, shared with the scanout on the MM2S channel.
+ *
+ * Author: Ahac Rafael Bela
+ * Created on: 25.04.2025
+ * Last modified: 17.05.2025
+ *************************************************************/
+//Protection macro
+#pragma once
+#ifndef DMAQUEUE_H
+#define DMAQUEUE_H
+
+/*************************************************************
+* Include section
+*************************************************************/
+#include "libs.h"
+
+/*************************************************************
+* Macro section
+*************************************************************/
+//Number of jobs per priority, must be a power of 2
+#define DMA_QUEUE_SIZE	16
+//Job flags, the caller has already flushed src and dst before the copy,
+//or nothing reads dst through the cache after it so it is not invalidated
+#define DMA_FLAG_NO_FLUSH		0x1
+#define DMA_FLAG_NO_INVALIDATE	0x2
+
+/*************************************************************
+* Enum section
+*************************************************************/
+typedef enum dmaPriority_t {
+	DMA_PRIO_HIGH,
+	DMA_PRIO_NORMAL,
+	DMA_PRIO_LOW,
+	DMA_PRIO_COUNT
+} dmaPriority;
+
+/*************************************************************
+* Struct section
+*************************************************************/
+//Called from the DMA completion interrupt when the job is done
+typedef void (*dmaCallback)(void *callbackRef, int status);
+
+typedef struct dmaJob_t {
+	u32 *src;				//Source address
+	u32 *dst;				//Destination address, NULL for the MM2S stream (VGA)
+	u32 length;				//Number of bytes to transfer
+	dmaPriority priority;	//Queue the job is submitted to
+	dmaCallback callback;	//Completion callback, may be NULL
+	void *callbackRef;		//Argument passed to the callback
+	u32 flags;				//DMA_FLAG_* options
+} dmaJob;
+
+typedef struct dmaQueueStats_t {
+	u32 submitted;			//Number of accepted jobs
+	u32 completed;			//Number of finished jobs
+	u32 rejected;			//Number of jobs refused because the queue was full
+	u32 depth;				//Number of jobs waiting in all queues
+	u32 maxDepth;			//Largest depth seen, the job being transferred is not counted
+	u64 bytes;				//Number of bytes transferred by finished jobs
+	XTime busyTime;			//Global timer ticks spent transferring jobs
+} dmaQueueStats;
+
+/*************************************************************
+* Function prototype section
+*************************************************************/
+//Queues a DMA job and starts it if the channel is idle.
+int dmaQueueSubmit(const dmaJob *job);
+//Returns the number of jobs a priority queue can still take.
+u32 dmaQueueFree(dmaPriority priority);
+//Takes the next job by priority, called from the completion interrupt.
+dmaJob *dmaQueuePop(void);
+//Finishes the job taken by dmaQueuePop and calls its callback.
+void dmaQueueFinish(dmaJob *job, XTime duration, int status);
+//Copies memory with both DMA channels in loopback.
+int dmaCopyAsync(u32 *dst, u32 *src, u32 length, dmaCallback callback, void *callbackRef);
+//Copies the queue counters.
+void dmaQueueGetStats(dmaQueueStats *stats);
+//Returns the transfer rate of finished jobs in bytes per second.
+u32 dmaQueueThroughput(void);
+
+#endif /* DMAQUEUE_H */
+
+/*************************************************************
+* End of file
+*************************************************************/
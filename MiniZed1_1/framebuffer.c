@@ -0,0 +1,622 @@
+/**************************************************************
+ * File: framebuffer.c
+ * Description: Multiple framebuffers with page flipping on
+ * VSync and selectable present modes.
+ *
+ * Author: Ahac Rafael Bela
+ * Created on: 24.04.2025
+ * Last modified: 17.05.2025
+ *************************************************************/
+
+/*************************************************************
+* Include section
+*************************************************************/
+#include "framebuffer.h"
+#include "vga.h"
+
+/*************************************************************
+* Global variable section
+*************************************************************/
+#ifndef FB_BASE_ADDR
+pixel vgaBuffers[FB_COUNT][FB_MAX_SIZE / sizeof(pixel)] __attribute__((aligned(FB_ALIGN)));
+#endif
+
+//Buffer that is drawn to and buffer that is scanned out
+pixel *vgaArray = vgaBuffers[1];
+pixel *volatile scanoutArray = vgaBuffers[0];
+//Draw buffer as the target of the drawing functions, its geometry is set by initDisplay
+surface screenSurface = {vgaBuffers[1], 0, 0, 0, FB_FORMAT, 0, {{0}}};
+
+//Row shown on each visible line, a table per framebuffer that is flipped together with it.
+//Lines may show rows of their own framebuffer in any order, or rows outside the framebuffers
+static pixel *lineRows[FB_COUNT][SCREEN_MAX_HEIGHT];
+pixel *const *volatile scanoutLineRows = lineRows[0];
+
+//Number of page flips done in VSyncIntrHandler
+volatile u32 flipCount = 0;
+
+static presentMode mode = PRESENT_FIFO;
+//The boot translation table maps all of DDR write-back cached
+static volatile fbMapping mapping = FB_MAP_CACHED;
+static volatile s32 scanIndex = 0;
+static volatile s32 readyIndex = -1;
+static s32 drawIndex = 1;
+
+//Flush statistics of the scanout
+volatile rowFlushStats rowFlushes = {0, 0, 0};
+
+//Rows of each framebuffer written by the CPU since they were last scanned out,
+//set by the drawing code on the draw buffer and cleared by the scanout
+static u32 dirtyRows[FB_COUNT][FB_DIRTY_WORDS];
+//Rows of each framebuffer that differ from the draw buffer, set on the other buffers
+//when a row of the draw buffer changes and copied over by present
+static u32 staleRows[FB_COUNT][FB_DIRTY_WORDS];
+
+//Start of the second over which skipped flushes are counted
+static XTime rateStart = 0;
+static u32 rateSkipped = 0;
+
+/*************************************************************
+* Function definition section
+*************************************************************/
+
+/*************************************************************
+* freeBuffer finds a buffer that is neither scanned out nor
+* 			queued for scanout.
+*
+* @param	None.
+*
+* @return
+* 			- index of the free buffer,
+* 			- -1 if there is none until the next VSync.
+*
+* @note		VSync interrupt is disabled while the indexes are read,
+* 			so a flip can not happen between the two reads.
+*************************************************************/
+static s32 freeBuffer(void) {
+	s32 index = -1;
+
+	XScuGic_Disable(ctrls->IntcInstancePtr, VSYNC_INTR_ID);
+	for(s32 i = 0; i < FB_COUNT; i++) {
+		if(i != scanIndex && i != readyIndex) {
+			index = i;
+			break;
+		}
+	}
+	XScuGic_Enable(ctrls->IntcInstancePtr, VSYNC_INTR_ID);
+
+	return index;
+}
+
+/*************************************************************
+* identityLineRows sets the row table of a framebuffer to its
+* 			own rows, in order.
+*
+* @param	index is the framebuffer.
+*
+* @return	None.
+*
+* @note		Pixel-doubled modes show each row on SCREEN_SCALE lines.
+*************************************************************/
+static void identityLineRows(s32 index) {
+	for(s32 line = 0; line < SCAN_HEIGHT; line++) {
+		lineRows[index][line] = FB_ROW(vgaBuffers[index], line / SCREEN_SCALE);
+	}
+}
+
+/*************************************************************
+* copyLineRows copies the row table of one framebuffer to
+* 			another one holding a copy of its frame.
+*
+* @param	to is the framebuffer to copy to.
+* @param	from is the framebuffer to copy from.
+*
+* @return	None.
+*
+* @note		Rows of the source frame are moved to the same rows of
+* 			the copy, rows outside the framebuffers are kept.
+*************************************************************/
+static void copyLineRows(s32 to, s32 from) {
+	UINTPTR start = (UINTPTR) vgaBuffers[from];
+
+	for(s32 line = 0; line < SCAN_HEIGHT; line++) {
+		UINTPTR offset = (UINTPTR) lineRows[from][line] - start;
+
+		lineRows[to][line] = (offset < FB_MAX_SIZE) ? (pixel *) ((u8 *) vgaBuffers[to] + offset) : lineRows[from][line];
+	}
+}
+
+/*************************************************************
+* setPresentMode selects how present hands frames to the scanout.
+*
+* @param	newMode is the present mode to use.
+*
+* @return	None.
+*
+* @note		With 2 framebuffers mailbox waits for VSync like FIFO,
+* 			as there is no third buffer to draw to meanwhile.
+*************************************************************/
+void setPresentMode(presentMode newMode) {
+	mode = newMode;
+}
+
+/*************************************************************
+* getPresentMode returns how present hands frames to the scanout.
+*
+* @param	None.
+*
+* @return	The current present mode.
+*
+* @note		None.
+*************************************************************/
+presentMode getPresentMode(void) {
+	return mode;
+}
+
+/*************************************************************
+* present hands the drawn frame to the scanout according to the
+* 			present mode and selects the next buffer to draw to.
+*
+* @param	None.
+*
+* @return	None.
+*
+* @note		Drawing is incremental, so the new draw buffer starts
+* 			as a copy of the presented frame and its row table.
+* 			Only the rows changed since it was last drawn are
+* 			copied, in runs of consecutive rows. Its dirty rows
+* 			become the OR of its own and the copied ones, which
+* 			include the rows of the presented frame not yet
+* 			flushed, so a one-row change flushes one row.
+*************************************************************/
+void present(void) {
+	s32 presented = drawIndex;
+	s32 next;
+
+	//DMA fills of the presented frame must be done before it is shown or copied
+	waitFill();
+	switch(mode) {
+	case PRESENT_IMMEDIATE:
+		//Drop any queued frame and switch the scanout base right away, HSync
+		//must not see the frame of one buffer with the row table of another
+		XScuGic_Disable(ctrls->IntcInstancePtr, HSYNC_INTR_ID);
+		XScuGic_Disable(ctrls->IntcInstancePtr, VSYNC_INTR_ID);
+		readyIndex = -1;
+		scanIndex = presented;
+		scanoutArray = vgaBuffers[presented];
+		scanoutLineRows = lineRows[presented];
+		XScuGic_Enable(ctrls->IntcInstancePtr, VSYNC_INTR_ID);
+		XScuGic_Enable(ctrls->IntcInstancePtr, HSYNC_INTR_ID);
+		break;
+	case PRESENT_FIFO:
+		//Wait until the previously queued frame is on screen
+		while(readyIndex != -1);
+		readyIndex = presented;
+		break;
+	case PRESENT_MAILBOX:
+		//Replace the queued frame, the replaced buffer becomes free
+		readyIndex = presented;
+		break;
+	}
+
+	//Wait for a buffer that is neither on screen nor queued
+	while((next = freeBuffer()) < 0);
+
+	u32 *stale = staleRows[next];
+	for(u32 word = 0; word < FB_DIRTY_WORDS; word++) dirtyRows[next][word] |= stale[word];
+	for(s32 row = 0; row < SCREEN_HEIGHT; row++) {
+		s32 end = row;
+
+		while(end < SCREEN_HEIGHT && (stale[end / 32] & (1u << (end % 32)))) end++;
+		if(end == row) continue;
+		//Rows are contiguous with their padding, a run is one copy
+		memcpy(FB_ROW(vgaBuffers[next], row), FB_ROW(vgaBuffers[presented], row), (end - row - 1) * FB_PITCH + FB_LINE_BYTES);
+		row = end;
+	}
+	memset(stale, 0, sizeof(staleRows[next]));
+	copyLineRows(next, presented);
+	drawIndex = next;
+	vgaArray = vgaBuffers[next];
+	screenSurface.base = vgaArray;
+}
+
+/*************************************************************
+* flipFramebuffers swaps the scanout base and row table to the
+* 			queued frame.
+*
+* @param	None.
+*
+* @return	None.
+*
+* @note		Called from VSyncIntrHandler, before the first line of
+* 			the next frame is transferred, so a frame is never
+* 			shown with the row table of another. The skipped
+* 			flushes per second are sampled here as well.
+*************************************************************/
+void flipFramebuffers(void) {
+	XTime now;
+
+	XTime_GetTime(&now);
+	if(now - rateStart >= COUNTS_PER_SECOND) {
+		rowFlushes.skippedPerSecond = rowFlushes.skipped - rateSkipped;
+		rateSkipped = rowFlushes.skipped;
+		rateStart = now;
+	}
+
+	if(readyIndex < 0) return;
+
+	scanIndex = readyIndex;
+	scanoutArray = vgaBuffers[scanIndex];
+	scanoutLineRows = lineRows[scanIndex];
+	readyIndex = -1;
+	flipCount++;
+}
+
+/*************************************************************
+* resetFramebuffers clears all framebuffers, shows the first one
+* 			and draws to the second one.
+*
+* @param	None.
+*
+* @return	None.
+*
+* @note		Called by setDisplayMode with HSync and VSync disabled
+* 			and no fill running, any queued frame is dropped. The
+* 			cleared buffers are flushed as a whole, so no row is
+* 			left dirty. The row tables start over in order.
+*************************************************************/
+void resetFramebuffers(void) {
+	memset(vgaBuffers, 0, FB_COUNT*FB_MAX_SIZE);
+	if(mapping == FB_MAP_CACHED) Xil_DCacheFlushRange((INTPTR) vgaBuffers, FB_COUNT*FB_MAX_SIZE);
+	memset(dirtyRows, 0, sizeof(dirtyRows));
+	memset(staleRows, 0, sizeof(staleRows));
+
+	scanIndex = 0;
+	readyIndex = -1;
+	drawIndex = 1;
+	scanoutArray = vgaBuffers[scanIndex];
+	vgaArray = vgaBuffers[drawIndex];
+	initLineRows();
+	updateScreenSurface();
+}
+
+/*************************************************************
+* initLineRows sets the row table of every framebuffer to its
+* 			own rows, in order.
+*
+* @param	None.
+*
+* @return	None.
+*
+* @note		Called when the display mode is set, with HSync and
+* 			VSync disabled.
+*************************************************************/
+void initLineRows(void) {
+	for(s32 i = 0; i < FB_COUNT; i++) identityLineRows(i);
+	scanoutLineRows = lineRows[scanIndex];
+}
+
+/*************************************************************
+* setLineRow sets the row a visible line of the draw buffer shows.
+*
+* @param	line is the visible line, below SCAN_HEIGHT.
+* @param	row is the first pixel of the row to show.
+*
+* @return
+* 			- XST_SUCCESS if successful,
+* 			- XST_FAILURE if the line is not visible.
+*
+* @note		The row is a row of the draw buffer (vgaArray), or one
+* 			outside the framebuffers that is aligned and padded
+* 			like a framebuffer row. Many lines may share one row,
+* 			e.g. of a uniform background. Rows outside the
+* 			framebuffers are flushed by the caller after writing,
+* 			they are not copied by present. The table is shown
+* 			with the frame on the VSync after present.
+*************************************************************/
+int setLineRow(u32 line, pixel *row) {
+	if(line >= (u32) SCAN_HEIGHT) return XST_FAILURE;
+
+	lineRows[drawIndex][line] = row;
+
+	return XST_SUCCESS;
+}
+
+/*************************************************************
+* getLineRow returns the row a visible line of the draw buffer
+* 			shows.
+*
+* @param	line is the visible line.
+*
+* @return
+* 			- the first pixel of the row,
+* 			- NULL if the line is not visible.
+*
+* @note		None.
+*************************************************************/
+pixel *getLineRow(u32 line) {
+	return (line < (u32) SCAN_HEIGHT) ? lineRows[drawIndex][line] : NULL;
+}
+
+/*************************************************************
+* resetLineRows sets the row table of the draw buffer to its own
+* 			rows, in order.
+*
+* @param	None.
+*
+* @return	None.
+*
+* @note		None.
+*************************************************************/
+void resetLineRows(void) {
+	identityLineRows(drawIndex);
+}
+
+/*************************************************************
+* reverseLineRows reverses a range of a row table in place.
+*
+* @param	rows is the row table.
+* @param	first is the first line of the range.
+* @param	last is the last line of the range.
+*
+* @return	None.
+*
+* @note		None.
+*************************************************************/
+static void reverseLineRows(pixel **rows, u32 first, u32 last) {
+	while(first < last) {
+		pixel *row = rows[first];
+
+		rows[first++] = rows[last];
+		rows[last--] = row;
+	}
+}
+
+/*************************************************************
+* scrollLineRows rotates a range of lines of the draw buffer's
+* 			row table, which scrolls it without moving a pixel.
+*
+* @param	first is the first line of the range.
+* @param	count is the number of lines in the range.
+* @param	lines is how far the range scrolls up, negative scrolls
+* 			it down. Lines leaving one end come in at the other.
+*
+* @return
+* 			- XST_SUCCESS if successful,
+* 			- XST_FAILURE if the range is not visible.
+*
+* @note		Lines outside the range are kept, so a split screen
+* 			scrolls only a part of it. Rotated by three reversals,
+* 			without a copy of the table.
+*************************************************************/
+int scrollLineRows(u32 first, u32 count, s32 lines) {
+	pixel **rows = lineRows[drawIndex];
+
+	if(first >= (u32) SCAN_HEIGHT || count > SCAN_HEIGHT - first) return XST_FAILURE;
+	if(count < 2) return XST_SUCCESS;
+
+	u32 shift = (u32) (((lines % (s32) count) + (s32) count) % (s32) count);
+	if(shift == 0) return XST_SUCCESS;
+
+	reverseLineRows(rows, first, first + shift - 1);
+	reverseLineRows(rows, first + shift, first + count - 1);
+	reverseLineRows(rows, first, first + count - 1);
+
+	return XST_SUCCESS;
+}
+
+/*************************************************************
+* updateScreenSurface points the screen surface at the draw
+* 			buffer, with the geometry of the display mode.
+*
+* @param	None.
+*
+* @return	None.
+*
+* @note		Called when the display mode is set, present only
+* 			moves the base. Clip rectangles of the old geometry
+* 			are dropped.
+*************************************************************/
+void updateScreenSurface(void) {
+	screenSurface.base = vgaArray;
+	screenSurface.width = SCREEN_WIDTH;
+	screenSurface.height = SCREEN_HEIGHT;
+	screenSurface.pitch = FB_PITCH;
+	screenSurface.format = currentMode->format;
+	screenSurface.clipDepth = 0;
+}
+
+/*************************************************************
+* setFramebufferMapping maps the MMU sections of the framebuffers
+* 			cached or non-cacheable.
+*
+* @param	newMapping is the mapping to use.
+*
+* @return
+* 			- XST_SUCCESS if successful,
+* 			- XST_FAILURE if the mapping is unknown.
+*
+* @note		Xil_SetTlbAttributes flushes the whole data cache after
+* 			each section, so no cached write is lost. When the
+* 			framebuffers do not end on a section boundary, the data
+* 			after them in the last section is mapped alike, place
+* 			them with FB_BASE_ADDR to avoid that.
+*************************************************************/
+int setFramebufferMapping(fbMapping newMapping) {
+	UINTPTR start = (UINTPTR) vgaBuffers;
+	UINTPTR end = start + FB_COUNT*FB_MAX_SIZE;
+	u32 attributes;
+
+	switch(newMapping) {
+	case FB_MAP_CACHED:
+		attributes = NORM_WB_CACHE;
+		break;
+	case FB_MAP_NONCACHED:
+		attributes = NORM_NONCACHE;
+		break;
+	default:
+		return XST_FAILURE;
+	}
+	if(newMapping == mapping) return XST_SUCCESS;
+
+	//DMA fills must not run while their cache maintenance changes
+	waitFill();
+	for(UINTPTR addr = start; addr < end; addr += FB_SECTION_SIZE) {
+		Xil_SetTlbAttributes(addr, attributes);
+	}
+	//Nothing of the framebuffers is left in the cache
+	memset(dirtyRows, 0, sizeof(dirtyRows));
+	mapping = newMapping;
+
+	return XST_SUCCESS;
+}
+
+/*************************************************************
+* getFramebufferMapping returns how the framebuffers are mapped.
+*
+* @param	None.
+*
+* @return	The current mapping.
+*
+* @note		None.
+*************************************************************/
+fbMapping getFramebufferMapping(void) {
+	return mapping;
+}
+
+/*************************************************************
+* markRowsChanged marks rows of the draw buffer as changed, so
+* 			present copies them to the next buffer drawn to.
+*
+* @param	y0 is the first row.
+* @param	rows is the number of rows.
+*
+* @return	None.
+*
+* @note		The rows are marked stale in every other buffer. Rows
+* 			written by the DMA are marked here only.
+*************************************************************/
+void markRowsChanged(u32 y0, u32 rows) {
+	for(s32 i = 0; i < FB_COUNT; i++) {
+		if(i == drawIndex) continue;
+		for(u32 y = y0; y < y0 + rows; y++) staleRows[i][y / 32] |= 1u << (y % 32);
+	}
+}
+
+/*************************************************************
+* markRowsDirty marks rows of the draw buffer as written by the
+* 			CPU, so they are flushed before they are scanned out.
+*
+* @param	y0 is the first row.
+* @param	rows is the number of rows.
+*
+* @return	None.
+*
+* @note		Rows written by the DMA need no flush and are not marked.
+* 			The rows are marked changed as well.
+*************************************************************/
+void markRowsDirty(u32 y0, u32 rows) {
+	u32 *dirty = dirtyRows[drawIndex];
+
+	for(u32 y = y0; y < y0 + rows; y++) dirty[y / 32] |= 1u << (y % 32);
+	markRowsChanged(y0, rows);
+}
+
+/*************************************************************
+* scanoutDirtyRows returns the dirty row bitmap of the buffer
+* 			that is scanned out.
+*
+* @param	None.
+*
+* @return	Pointer to the bitmap.
+*
+* @note		The index is taken from scanoutArray itself, present
+* 			in immediate mode may change it between two HSyncs.
+*************************************************************/
+static u32 *scanoutDirtyRows(void) {
+	return dirtyRows[((u8 *) scanoutArray - (u8 *) vgaBuffers) / FB_MAX_SIZE];
+}
+
+/*************************************************************
+* flushScanoutRow flushes a row of the scanout buffer if the CPU
+* 			wrote it since it was last scanned out. Untouched rows
+* 			are scanned out without any cache maintenance.
+*
+* @param	row is the row to flush.
+*
+* @return	None.
+*
+* @note		Called from HSyncIntrHandler through the prefetch
+* 			pipeline. The drawing code never writes the scanout
+* 			buffer, so the bitmap is not shared with it. Nothing
+* 			is done when the framebuffers are non-cacheable.
+*************************************************************/
+void flushScanoutRow(u32 row) {
+	u32 *dirty = &scanoutDirtyRows()[row / 32];
+	u32 bit = 1u << (row % 32);
+
+	if(mapping != FB_MAP_CACHED) return;
+	if(*dirty & bit) {
+		*dirty &= ~bit;
+		Xil_DCacheFlushRange((INTPTR) FB_ROW(scanoutArray, row), FB_LINE_BYTES);
+		rowFlushes.flushed++;
+	} else {
+		rowFlushes.skipped++;
+	}
+}
+
+/*************************************************************
+* flushScanoutLine flushes the row a visible line shows if it is
+* 			a row of the scanout buffer the CPU wrote since it was
+* 			last scanned out.
+*
+* @param	line is the visible line.
+*
+* @return	None.
+*
+* @note		Called from HSyncIntrHandler through the prefetch
+* 			pipeline. Rows outside the framebuffers are flushed by
+* 			whoever writes them.
+*************************************************************/
+void flushScanoutLine(u32 line) {
+	UINTPTR offset = (UINTPTR) scanoutLineRows[line] - (UINTPTR) scanoutArray;
+
+	if(offset < FB_SIZE) flushScanoutRow(offset / FB_PITCH);
+}
+
+/*************************************************************
+* flushScanoutFrame flushes all rows of the scanout buffer the
+* 			CPU wrote since it was last scanned out.
+*
+* @param	None.
+*
+* @return	None.
+*
+* @note		Called from VSyncIntrHandler in SG mode, where the DMA
+* 			reads the whole frame right after VSync. When more
+* 			rows are dirty than a range flush is worth, the whole
+* 			data cache is flushed instead. Nothing is done when the
+* 			framebuffers are non-cacheable.
+*************************************************************/
+void flushScanoutFrame(void) {
+	u32 *dirty = scanoutDirtyRows();
+	u32 count = 0;
+
+	if(mapping != FB_MAP_CACHED) return;
+	for(s32 row = 0; row < SCREEN_HEIGHT; row++) {
+		if(dirty[row / 32] & (1u << (row % 32))) count++;
+	}
+	if(count * PITCH < FILL_FLUSH_ALL_BYTES) {
+		for(s32 row = 0; row < SCREEN_HEIGHT; row++) flushScanoutRow(row);
+		return;
+	}
+
+	Xil_DCacheFlush();
+	memset(dirty, 0, FB_DIRTY_WORDS * sizeof(u32));
+	rowFlushes.flushed += count;
+	rowFlushes.skipped += SCREEN_HEIGHT - count;
+}
+
+/*************************************************************
+* End of file
+*************************************************************/
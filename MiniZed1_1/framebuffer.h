@@ -0,0 +1,133 @@
+/**************************************************************
+ * File: framebuffer.h
+ * Description: Multiple framebuffers with page flipping on
+ * VSync and selectable present modes.
+ *
+ * Author: Ahac Rafael Bela
+ * Created on: 24.04.2025
+ * Last modified: 17.05.2025
+ *************************************************************/
+//Protection macro
+#pragma once
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+/*************************************************************
+* Include section
+*************************************************************/
+#include "libs.h"
+#include "xil_mmu.h"
+
+/*************************************************************
+* Macro section
+*************************************************************/
+//Number of framebuffers, 2 for double and 3 for triple buffering
+#define FB_COUNT	3
+//Size of one framebuffer in bytes, rows padded to FB_PITCH
+#define FB_SIZE		(SCREEN_HEIGHT * FB_PITCH)
+//Space kept for each framebuffer, the size of the largest display mode
+#define FB_MAX_SIZE	(SCREEN_MAX_HEIGHT * FB_MAX_PITCH)
+//Size of an MMU section, the unit in which the framebuffer mapping is changed
+#define FB_SECTION_SIZE	0x100000
+//Alignment of the framebuffers, an MMU section, so a mapping change starts at
+//the first framebuffer (and is a multiple of the cache line and burst boundary)
+#define FB_ALIGN	FB_SECTION_SIZE
+//Define to place the framebuffers at an address kept free in the linker script,
+//e.g. MEM_BASE_ADDR, instead of in .bss
+//#define FB_BASE_ADDR	MEM_BASE_ADDR
+
+//Words of the dirty row bitmap of one framebuffer
+#define FB_DIRTY_WORDS	((SCREEN_MAX_HEIGHT + 31) / 32)
+
+//Mapping of the framebuffers set up on startup, FB_MAP_CACHED or FB_MAP_NONCACHED
+#ifndef FB_MAPPING
+#define FB_MAPPING	FB_MAP_CACHED
+#endif
+
+#if defined(FB_BASE_ADDR) && (FB_BASE_ADDR % FB_ALIGN)
+#error "FB_BASE_ADDR must be aligned to FB_ALIGN"
+#endif
+
+/*************************************************************
+* Enum section
+*************************************************************/
+typedef enum presentMode_t {
+	PRESENT_IMMEDIATE,	//Frame is shown right away, may tear
+	PRESENT_FIFO,		//Frames are shown in order on VSync, present waits for a free slot
+	PRESENT_MAILBOX		//Latest frame is shown on VSync, older queued frames are dropped
+} presentMode;
+
+typedef enum fbMapping_t {
+	FB_MAP_CACHED,		//Write-back cached, dirty rows are flushed before they are scanned out
+	FB_MAP_NONCACHED	//Normal non-cacheable and bufferable, stores are combined in the
+						//store buffer and reach memory without any cache maintenance
+} fbMapping;
+
+/*************************************************************
+* Struct section
+*************************************************************/
+typedef struct rowFlushStats_t {
+	u32 flushed;			//Rows flushed before they were scanned out
+	u32 skipped;			//Rows scanned out without cache maintenance
+	u32 skippedPerSecond;	//Skipped flushes over the last second
+} rowFlushStats;
+
+/*************************************************************
+* Variable declaration section
+*************************************************************/
+#ifdef FB_BASE_ADDR
+#define vgaBuffers	((pixel (*)[FB_MAX_SIZE / sizeof(pixel)]) FB_BASE_ADDR)
+#else
+extern pixel vgaBuffers[FB_COUNT][FB_MAX_SIZE / sizeof(pixel)];
+#endif
+extern surface screenSurface;
+//Row shown on each visible line of the frame that is scanned out
+extern pixel *const *volatile scanoutLineRows;
+extern volatile u32 flipCount;
+extern volatile rowFlushStats rowFlushes;
+
+/*************************************************************
+* Function prototype section
+*************************************************************/
+//Selects how present hands frames to the scanout.
+void setPresentMode(presentMode mode);
+//Returns how present hands frames to the scanout.
+presentMode getPresentMode(void);
+//Hands the drawn frame to the scanout and selects the next buffer to draw to.
+void present(void);
+//Swaps the scanout base and row table to the queued frame, called on VSync.
+void flipFramebuffers(void);
+//Clears all framebuffers and shows the first one, used when the display mode changes.
+void resetFramebuffers(void);
+//Points the screen surface at the draw buffer, with the geometry of the display mode.
+void updateScreenSurface(void);
+//Sets the rows of every framebuffer's row table to its own rows, in order.
+void initLineRows(void);
+//Sets the row a visible line of the draw buffer shows.
+int setLineRow(u32 line, pixel *row);
+//Returns the row a visible line of the draw buffer shows.
+pixel *getLineRow(u32 line);
+//Sets the draw buffer's row table to its own rows, in order.
+void resetLineRows(void);
+//Rotates a range of lines of the draw buffer's row table.
+int scrollLineRows(u32 first, u32 count, s32 lines);
+//Maps the framebuffers cached or non-cacheable.
+int setFramebufferMapping(fbMapping newMapping);
+//Returns how the framebuffers are mapped.
+fbMapping getFramebufferMapping(void);
+//Marks rows of the draw buffer as changed, by the CPU or the DMA.
+void markRowsChanged(u32 y0, u32 rows);
+//Marks rows of the draw buffer as written by the CPU.
+void markRowsDirty(u32 y0, u32 rows);
+//Flushes a row of the scanout buffer if the CPU wrote it since it was last scanned out.
+void flushScanoutRow(u32 row);
+//Flushes the row a visible line shows if it is a row of the scanout buffer the CPU wrote.
+void flushScanoutLine(u32 line);
+//Flushes all rows of the scanout buffer the CPU wrote since it was last scanned out.
+void flushScanoutFrame(void);
+
+#endif /* FRAMEBUFFER_H */
+
+/*************************************************************
+* End of file
+*************************************************************/
@@ -0,0 +1,149 @@
+/**************************************************************
+ * File: glyphcache.c
+ * Description: Cache of characters expanded to rows of pixels in
+ * their colors, so drawing a character copies its rows.
+ *
+ * Author: Ahac Rafael Bela
+ * Created on: 16.05.2025
+ * Last modified: 16.05.2025
+ *************************************************************/
+
+/*************************************************************
+* Include section
+*************************************************************/
+#include "glyphcache.h"
+#include "kernels.h"
+
+/*************************************************************
+* Struct section
+*************************************************************/
+typedef struct glyphKey_t {
+	u32 scale;				//Scale of the character, 0 for an empty slot
+	pixel fg;				//Pixel of the set bits, a palette index in the indexed formats
+	pixel bg;				//Pixel of the clear bits
+	u8 c;					//Character
+	u32 lastUsed;			//Lookup that last found or filled the slot
+} glyphKey;
+
+/*************************************************************
+* Global variable section
+*************************************************************/
+glyphCacheStats glyphStats = {0, 0, 0};
+
+static glyphKey glyphKeys[GLYPH_CACHE_SETS][GLYPH_CACHE_WAYS];
+//Expanded rows of the characters, one per row of the font, the scaled rows repeat them
+static pixel glyphRows[GLYPH_CACHE_SETS][GLYPH_CACHE_WAYS][CHAR_HEIGHT][GLYPH_ROW_PIXELS] __attribute__((aligned(KERNEL_VECTOR_BYTES)));
+//Counts the lookups, the slot with the oldest count is reused first
+static u32 lookups = 0;
+
+/*************************************************************
+* Function definition section
+*************************************************************/
+
+/*************************************************************
+* glyphSet returns the set a character is kept in.
+*
+* @param	c is the character.
+* @param	scale is its scale.
+* @param	fg is the pixel of its set bits.
+* @param	bg is the pixel of its clear bits.
+*
+* @return	The set.
+*
+* @note		Text in one color spreads over the sets by character.
+*************************************************************/
+static inline u32 glyphSet(u8 c, u32 scale, pixel fg, pixel bg) {
+	return (c + scale + fg + ((u32) bg << 1)) % GLYPH_CACHE_SETS;
+}
+
+/*************************************************************
+* findGlyph finds the expanded rows of a character, or the slot
+* 			to expand them into.
+*
+* @param	c is the character.
+* @param	scale is its scale, at most GLYPH_CACHE_MAX_SCALE.
+* @param	fg is the pixel of its set bits.
+* @param	bg is the pixel of its clear bits.
+* @param	found is set to 1 if the rows are cached, to 0 if the
+* 			caller has to expand them into the slot returned.
+*
+* @return	The first of CHAR_HEIGHT rows, GLYPH_ROW_PIXELS apart.
+*
+* @note		A miss takes an empty slot of the set of the character,
+* 			or the one used least recently. The colors are keyed by
+* 			their pixels, so palette changes do not leave stale
+* 			indices behind.
+*************************************************************/
+pixel *findGlyph(u8 c, u32 scale, pixel fg, pixel bg, int *found) {
+	u32 set = glyphSet(c, scale, fg, bg);
+	glyphKey *keys = glyphKeys[set];
+	u32 oldest = 0;
+
+	lookups++;
+	for(u32 way = 0; way < GLYPH_CACHE_WAYS; way++) {
+		if(keys[way].scale == scale && keys[way].c == c && keys[way].fg == fg && keys[way].bg == bg) {
+			keys[way].lastUsed = lookups;
+			glyphStats.hits++;
+			*found = 1;
+			return glyphRows[set][way][0];
+		}
+		//Empty slots are used before any character is dropped
+		if(keys[oldest].scale && (!keys[way].scale || keys[way].lastUsed < keys[oldest].lastUsed)) oldest = way;
+	}
+
+	glyphStats.misses++;
+	if(keys[oldest].scale) glyphStats.evictions++;
+	keys[oldest] = (glyphKey) {scale, fg, bg, c, lookups};
+	*found = 0;
+
+	return glyphRows[set][oldest][0];
+}
+
+/*************************************************************
+* flushGlyphCache drops all cached characters.
+*
+* @param	None.
+*
+* @return	None.
+*
+* @note		None.
+*************************************************************/
+void flushGlyphCache(void) {
+	for(u32 set = 0; set < GLYPH_CACHE_SETS; set++) {
+		for(u32 way = 0; way < GLYPH_CACHE_WAYS; way++) glyphKeys[set][way].scale = 0;
+	}
+}
+
+/*************************************************************
+* resetGlyphCacheStats clears the hit and miss counters.
+*
+* @param	None.
+*
+* @return	None.
+*
+* @note		None.
+*************************************************************/
+void resetGlyphCacheStats(void) {
+	glyphStats.hits = 0;
+	glyphStats.misses = 0;
+	glyphStats.evictions = 0;
+}
+
+/*************************************************************
+* glyphCacheHitRate returns the share of lookups that hit.
+*
+* @param	None.
+*
+* @return	Hits per thousand lookups, 0 before the first one.
+*
+* @note		None.
+*************************************************************/
+u32 glyphCacheHitRate(void) {
+	u32 total = glyphStats.hits + glyphStats.misses;
+
+	return total ? (u32) ((u64) glyphStats.hits * 1000 / total) : 0;
+}
+
+/*************************************************************
+* End of file
+*************************************************************/
@@ -0,0 +1,62 @@
+/**************************************************************
+ * File: glyphcache.h
+ * Description: Cache of characters expanded to rows of pixels in
+ * their colors, so drawing a character copies its rows.
+ *
+ * Author: Ahac Rafael Bela
+ * Created on: 16.05.2025
+ * Last modified: 16.05.2025
+ *************************************************************/
+//Protection macro
+#pragma once
+#ifndef GLYPHCACHE_H
+#define GLYPHCACHE_H
+
+/*************************************************************
+* Include section
+*************************************************************/
+#include "vga.h"
+
+/*************************************************************
+* Macro section
+*************************************************************/
+//Largest scale of the cached characters, larger ones are drawn as runs
+#define GLYPH_CACHE_MAX_SCALE	CHAR_EXPAND_MAX_SCALE
+//Sets the characters are spread over and characters kept in each set,
+//64 characters of up to 2 KB
+#define GLYPH_CACHE_SETS		16
+#define GLYPH_CACHE_WAYS		4
+//Storage units of one expanded row of a character, padded to whole words
+#define GLYPH_ROW_PIXELS		(SURFACE_PITCH(CHAR_WIDTH * GLYPH_CACHE_MAX_SCALE) / sizeof(pixel))
+
+/*************************************************************
+* Struct section
+*************************************************************/
+typedef struct glyphCacheStats_t {
+	u32 hits;				//Characters found expanded
+	u32 misses;				//Characters expanded into a slot
+	u32 evictions;			//Misses that dropped the least recently used character of their set
+} glyphCacheStats;
+
+/*************************************************************
+* Variable declaration section
+*************************************************************/
+extern glyphCacheStats glyphStats;
+
+/*************************************************************
+* Function prototype section
+*************************************************************/
+//Finds the expanded rows of a character, or the slot to expand them into.
+pixel *findGlyph(u8 c, u32 scale, pixel fg, pixel bg, int *found);
+//Drops all cached characters.
+void flushGlyphCache(void);
+//Clears the hit and miss counters.
+void resetGlyphCacheStats(void);
+//Returns the share of lookups that hit, in tenths of a percent.
+u32 glyphCacheHitRate(void);
+
+#endif /* GLYPHCACHE_H */
+
+/*************************************************************
+* End of file
+*************************************************************/
@@ -0,0 +1,186 @@
+/**************************************************************
+ * File: kernels.c
+ * Description: Fill, copy and two-color expand kernels the
+ * drawing functions run on rows of pixels, with 128 bit NEON or
+ * SSE2 versions and a scalar fallback.
+ *
+ * Author: Ahac Rafael Bela
+ * Created on: 13.05.2025
+ * Last modified: 13.05.2025
+ *************************************************************/
+
+/*************************************************************
+* Include section
+*************************************************************/
+#include "kernels.h"
+#if KERNELS_NEON
+#include <arm_neon.h>
+#elif KERNELS_SSE2
+#include <emmintrin.h>
+#endif
+
+/*************************************************************
+* Global variable section
+*************************************************************/
+//Kernels in use, the vector ones when they are built
+static kernelPath path = KERNELS_HAVE_VECTOR ? KERNELS_VECTOR : KERNELS_SCALAR;
+
+/*************************************************************
+* Function definition section
+*************************************************************/
+
+/*************************************************************
+* setKernelPath selects the scalar or vector kernels.
+*
+* @param	newPath is the kernels to use.
+*
+* @return
+* 			- XST_SUCCESS if successful,
+* 			- XST_FAILURE if the vector kernels are not built.
+*
+* @note		Used by the benchmark to compare both.
+*************************************************************/
+int setKernelPath(kernelPath newPath) {
+	if(newPath == KERNELS_VECTOR && !KERNELS_HAVE_VECTOR) return XST_FAILURE;
+	path = newPath;
+
+	return XST_SUCCESS;
+}
+
+/*************************************************************
+* getKernelPath returns the kernels in use.
+*
+* @param	None.
+*
+* @return	KERNELS_SCALAR or KERNELS_VECTOR.
+*
+* @note		None.
+*************************************************************/
+kernelPath getKernelPath(void) {
+	return path;
+}
+
+/*************************************************************
+* useVector checks if a run goes through the vector kernels.
+*
+* @param	count is the number of words of the run.
+*
+* @return	1 if it does, 0 otherwise.
+*
+* @note		None.
+*************************************************************/
+static inline int useVector(u32 count) {
+	return KERNELS_HAVE_VECTOR && path == KERNELS_VECTOR && count >= KERNEL_VECTOR_MIN;
+}
+
+/*************************************************************
+* fillWords fills words with a value.
+*
+* @param	dst is the first word.
+* @param	value is the value to store.
+* @param	count is the number of words.
+*
+* @return	None.
+*
+* @note		The vector kernel stores words until dst is on a
+* 			KERNEL_VECTOR_BYTES boundary, then two vectors at a
+* 			time, the rest again by word.
+*************************************************************/
+void fillWords(u32 *dst, u32 value, u32 count) {
+	if(useVector(count)) {
+		for(; (UINTPTR) dst % KERNEL_VECTOR_BYTES; count--) *dst++ = value;
+#if KERNELS_NEON
+		uint32x4_t v = vdupq_n_u32(value);
+
+		for(; count >= 8; count -= 8, dst += 8) {
+			vst1q_u32(dst, v);
+			vst1q_u32(dst + 4, v);
+		}
+#elif KERNELS_SSE2
+		__m128i v = _mm_set1_epi32(value);
+
+		for(; count >= 8; count -= 8, dst += 8) {
+			_mm_store_si128((__m128i *) dst, v);
+			_mm_store_si128((__m128i *) (dst + 4), v);
+		}
+#endif
+	}
+	for(; count; count--) *dst++ = value;
+}
+
+/*************************************************************
+* copyWords copies words.
+*
+* @param	dst is the first word to copy to.
+* @param	src is the first word to copy from.
+* @param	count is the number of words.
+*
+* @return	None.
+*
+* @note		The runs must not overlap. The vector kernel aligns the
+* 			stores, the loads may be unaligned.
+*************************************************************/
+void copyWords(u32 *dst, const u32 *src, u32 count) {
+	if(useVector(count)) {
+		for(; (UINTPTR) dst % KERNEL_VECTOR_BYTES; count--) *dst++ = *src++;
+#if KERNELS_NEON
+		for(; count >= 8; count -= 8, dst += 8, src += 8) {
+			uint32x4_t a = vld1q_u32(src), b = vld1q_u32(src + 4);
+
+			vst1q_u32(dst, a);
+			vst1q_u32(dst + 4, b);
+		}
+#elif KERNELS_SSE2
+		for(; count >= 8; count -= 8, dst += 8, src += 8) {
+			__m128i a = _mm_loadu_si128((const __m128i *) src), b = _mm_loadu_si128((const __m128i *) (src + 4));
+
+			_mm_store_si128((__m128i *) dst, a);
+			_mm_store_si128((__m128i *) (dst + 4), b);
+		}
+#endif
+	}
+	for(; count; count--) *dst++ = *src++;
+}
+
+/*************************************************************
+* expandWords writes one of two words for each bit of a mask,
+* 			e.g. a row of a glyph to pixels.
+*
+* @param	dst is the first word to write.
+* @param	bits is the mask, its top bit selects the first word.
+* @param	count is the number of words, at most 32.
+* @param	fg is the word written for a set bit.
+* @param	bg is the word written for a clear bit.
+*
+* @return	None.
+*
+* @note		The vector kernel selects four words at a time with a
+* 			compare against the bits of four lanes, without a
+* 			branch per word.
+*************************************************************/
+void expandWords(u32 *dst, u32 bits, u32 count, u32 fg, u32 bg) {
+	if(useVector(count)) {
+		for(; (UINTPTR) dst % KERNEL_VECTOR_BYTES; count--, bits <<= 1) *dst++ = (bits & 0x80000000) ? fg : bg;
+#if KERNELS_NEON
+		static const u32 lanes[4] = {0x80000000, 0x40000000, 0x20000000, 0x10000000};
+		uint32x4_t mask = vld1q_u32(lanes), f = vdupq_n_u32(fg), b = vdupq_n_u32(bg);
+
+		for(; count >= 4; count -= 4, dst += 4, bits <<= 4) {
+			vst1q_u32(dst, vbslq_u32(vtstq_u32(vdupq_n_u32(bits), mask), f, b));
+		}
+#elif KERNELS_SSE2
+		__m128i mask = _mm_set_epi32(0x10000000, 0x20000000, 0x40000000, (int) 0x80000000);
+		__m128i f = _mm_set1_epi32(fg), b = _mm_set1_epi32(bg);
+
+		for(; count >= 4; count -= 4, dst += 4, bits <<= 4) {
+			__m128i set = _mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(bits), mask), mask);
+			_mm_store_si128((__m128i *) dst, _mm_or_si128(_mm_and_si128(set, f), _mm_andnot_si128(set, b)));
+		}
+#endif
+	}
+	for(; count; count--, bits <<= 1) *dst++ = (bits & 0x80000000) ? fg : bg;
+}
+
+/*************************************************************
+* End of file
+*************************************************************/
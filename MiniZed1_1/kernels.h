@@ -0,0 +1,66 @@
+/**************************************************************
+ * File: kernels.h
+ * Description: Fill, copy and two-color expand kernels the
+ * drawing functions run on rows of pixels, with 128 bit NEON or
+ * SSE2 versions and a scalar fallback.
+ *
+ * Author: Ahac Rafael Bela
+ * Created on: 13.05.2025
+ * Last modified: 13.05.2025
+ *************************************************************/
+//Protection macro
+#pragma once
+#ifndef KERNELS_H
+#define KERNELS_H
+
+/*************************************************************
+* Include section
+*************************************************************/
+#include "libs.h"
+
+/*************************************************************
+* Macro section
+*************************************************************/
+//Vector kernels are built with NEON on the target (compiled with -mfpu=neon) and with
+//SSE2 in the host simulator, other builds only have the scalar ones
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define KERNELS_NEON		1
+#define KERNELS_HAVE_VECTOR	1
+#elif defined(__SSE2__)
+#define KERNELS_SSE2		1
+#define KERNELS_HAVE_VECTOR	1
+#else
+#define KERNELS_HAVE_VECTOR	0
+#endif
+//Bytes of one vector store, the vector kernels align their stores to it
+#define KERNEL_VECTOR_BYTES	16
+//Shortest run worth the vector kernels in words, shorter runs stay scalar
+#define KERNEL_VECTOR_MIN	8
+
+/*************************************************************
+* Enum section
+*************************************************************/
+typedef enum kernelPath_t {
+	KERNELS_SCALAR,		//One 32 bit store per word
+	KERNELS_VECTOR		//128 bit stores, aligned head and tail done by word
+} kernelPath;
+
+/*************************************************************
+* Function prototype section
+*************************************************************/
+//Selects the scalar or vector kernels.
+int setKernelPath(kernelPath newPath);
+//Returns the kernels in use.
+kernelPath getKernelPath(void);
+//Fills words with a value.
+void fillWords(u32 *dst, u32 value, u32 count);
+//Copies words.
+void copyWords(u32 *dst, const u32 *src, u32 count);
+//Writes one of two words for each bit of a mask, from its top bit down.
+void expandWords(u32 *dst, u32 bits, u32 count, u32 fg, u32 bg);
+
+#endif /* KERNELS_H */
+
+/*************************************************************
+* End of file
+*************************************************************/
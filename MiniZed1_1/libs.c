@@ -5,13 +5,20 @@
 *
 * Author: Ahac Rafael Bela
 * Created on: 01.03.2025
-* Last modified: 14.04.2025
+* Last modified: 17.05.2025
 *************************************************************/
 
 /*************************************************************
 * Include section
 *************************************************************/
 #include "libs.h"
+#include "sgring.h"
+#include "framebuffer.h"
+#include "dmaqueue.h"
+#include "prefetch.h"
+#include "palette.h"
+#include "display.h"
+#include "rle.h"
 
 /*************************************************************
 * Global variable section
@@ -19,9 +26,35 @@
 controllers *ctrls;
 volatile u8 caughtChar;
 volatile u8 receivedCount = 0;
+volatile dmaStats mm2sStats = {0, 0, 0, 0, (XTime) -1, 0, 0, 0};
+volatile dmaErrors dmaErrorStats;
+volatile isrStats hsyncStats = {0, 0, 0};
+volatile isrStats vsyncStats = {0, 0, 0};
 
+//Line of the beam, FIRST_LINE from every VSync on
 static volatile s32 lineIndex = 0;
 
+//MM2S channel state shared between dmaReadReg and MM2SIntrHandler
+static volatile u8 dmaBusy = 0;
+static volatile XTime dmaStartTime;
+static u32 dmaLength = 0;
+//Scanout lines waiting for the channel, written by dmaReadReg, read by dmaNext
+static u32 *pendingLines[SCAN_QUEUE_SIZE];
+static u32 pendingLength[SCAN_QUEUE_SIZE];
+static volatile u32 pendingHead = 0;
+static volatile u32 pendingTail = 0;
+//Queued job being transferred, NULL for scanout lines
+static dmaJob *volatile activeJob = NULL;
+//Job interrupted between two slices to let scanout lines through
+static dmaJob *suspendedJob = NULL;
+//Bytes of the active or suspended job already transferred, length of its slice in flight
+static u32 jobOffset = 0;
+static u32 sliceLength = 0;
+//Summed latency of the slices of the job
+static XTime jobTime = 0;
+//Number of channels (MM2S and S2MM for copies) still running for the transfer
+static volatile u8 channelsLeft = 0;
+
 /*************************************************************
 * Function definition section
 *************************************************************/
@@ -56,6 +89,12 @@ int initPlatform(controllers *ctrls) {
 		return XST_FAILURE;
 	} 	else xil_printf("Initialization of DMA done!\n\r");
 
+	//Palette the indexed framebuffers are expanded with, set before the first HSync
+	if(FB_INDEXED) paletteInit();
+
+	//Timing of the boot display mode, set before the first VSync
+	initDisplay();
+
 	//Initialize interrupts
 	Status = initInterrupt(ctrls);
 	if(Status != XST_SUCCESS) {
@@ -114,7 +153,8 @@ int initUART(controllers *ctrls) {
 * 			- XST_SUCCESS if successful,
 * 			- XST_FAILURE otherwise.
 *
-* @note		None.
+* @note		In SG mode the scanout descriptor ring is built here
+* 			and whole frames are submitted from VSyncIntrHandler.
 *************************************************************/
 int initDMA(controllers *ctrls) {
 	int Status;
@@ -129,13 +169,29 @@ int initDMA(controllers *ctrls) {
 	//Initialize DMA
 	Status = XAxiDma_CfgInitialize(ctrls->AxiDma, ctrls->CfgPtr);
 	if(Status != XST_SUCCESS) {xil_printf("Initialization failed"); return XST_FAILURE;}
-	if(XAxiDma_HasSg(ctrls->AxiDma)) {xil_printf("Device configured as SG mode \r\n"); return XST_FAILURE;}
+	if(XAxiDma_HasSg(ctrls->AxiDma)) {
+		xil_printf("Device configured as SG mode \r\n");
+		//Indexed rows are expanded line by line ahead of the beam, the ring sends the framebuffer rows themselves
+		if(FB_INDEXED) {xil_printf("Indexed framebuffers need the DMA in simple mode\r\n"); return XST_FAILURE;}
+		//So are the rows of pixel-doubled modes, to repeat their pixels
+		if(SCREEN_SCALE > 1) {xil_printf("Pixel-doubled modes need the DMA in simple mode\r\n"); return XST_FAILURE;}
+		//Set up the descriptor ring for whole frames
+		Status = sgRingInit(&scanoutRing, ctrls->CfgPtr->BaseAddr + XAXIDMA_TX_OFFSET, SG_ROWS_PER_BD);
+		if(Status != XST_SUCCESS) {xil_printf("Descriptor ring setup failed\r\n"); return XST_FAILURE;}
+	} else {
+		//Setting DMA MM2S run/stop bit to 1 once, dmaReadReg only writes address and length
+		Xil_Out32(ctrls->CfgPtr->BaseAddr + XAXIDMA_CR_OFFSET, XAXIDMA_CR_RUNSTOP_MASK);
+		//Setting DMA S2MM run/stop bit to 1, used by the loopback copies
+		if(ctrls->CfgPtr->HasS2Mm) {
+			Xil_Out32(ctrls->CfgPtr->BaseAddr + XAXIDMA_RX_OFFSET + XAXIDMA_CR_OFFSET, XAXIDMA_CR_RUNSTOP_MASK);
+		}
+	}
 
 	return Status;
 }
 
 /*************************************************************
-* initInterrupt initializes MM2S, HSync and UART interrupts.
+* initInterrupt initializes MM2S, S2MM, HSync, VSync and UART interrupts.
 *
 * @param	ctrls is a pointer to the controllers structure which
 * 			holds necessary configuration and instance variables
@@ -167,6 +223,8 @@ int initInterrupt(controllers *ctrls) {
     XScuGic_SetPriorityTriggerType(ctrls->IntcInstancePtr, HSYNC_INTR_ID, 0xA0, 0x3);
     XScuGic_SetPriorityTriggerType(ctrls->IntcInstancePtr, UART_INTR_ID, 0xA8, 0x3);
     XScuGic_SetPriorityTriggerType(ctrls->IntcInstancePtr, VSYNC_INTR_ID, 0x98, 0x3);
+    XScuGic_SetPriorityTriggerType(ctrls->IntcInstancePtr, MM2S_INTR_ID, 0x90, 0x3);
+    XScuGic_SetPriorityTriggerType(ctrls->IntcInstancePtr, S2MM_INTR_ID, 0x90, 0x3);
 
 	//Connect interrupts to their corresponding handlers
 	Status = XScuGic_Connect(ctrls->IntcInstancePtr, HSYNC_INTR_ID, (Xil_InterruptHandler) HSyncIntrHandler, ctrls->IntcInstancePtr);
@@ -175,13 +233,23 @@ int initInterrupt(controllers *ctrls) {
 	if(Status != XST_SUCCESS) return XST_FAILURE;
 	Status = XScuGic_Connect(ctrls->IntcInstancePtr, UART_INTR_ID, (Xil_InterruptHandler) XUartPs_InterruptHandler, ctrls->UartPs);
 	if(Status != XST_SUCCESS) return XST_FAILURE;
+	Status = XScuGic_Connect(ctrls->IntcInstancePtr, MM2S_INTR_ID, (Xil_InterruptHandler) MM2SIntrHandler, ctrls->IntcInstancePtr);
+	if(Status != XST_SUCCESS) return XST_FAILURE;
+	Status = XScuGic_Connect(ctrls->IntcInstancePtr, S2MM_INTR_ID, (Xil_InterruptHandler) S2MMIntrHandler, ctrls->IntcInstancePtr);
+	if(Status != XST_SUCCESS) return XST_FAILURE;
 
 	//Disable all DMA interrupts before setup
 	XAxiDma_IntrDisable(ctrls->AxiDma, XAXIDMA_IRQ_ALL_MASK, XAXIDMA_DMA_TO_DEVICE);
-
-	//Enable IOC (interrupt on completion) for DMA to device (DMA read/MM2S)
-	XAxiDma_IntrEnable(ctrls->AxiDma, XAXIDMA_IRQ_IOC_MASK, XAXIDMA_DMA_TO_DEVICE);
-
+	XAxiDma_IntrDisable(ctrls->AxiDma, XAXIDMA_IRQ_ALL_MASK, XAXIDMA_DEVICE_TO_DMA);
+
+	//Enable IOC (interrupt on completion) and error interrupts for DMA to device (DMA read/MM2S),
+	//in SG mode nothing waits for a descriptor to finish, so only errors interrupt
+	if(XAxiDma_HasSg(ctrls->AxiDma)) XAxiDma_IntrEnable(ctrls->AxiDma, XAXIDMA_IRQ_ERROR_MASK, XAXIDMA_DMA_TO_DEVICE);
+	else XAxiDma_IntrEnable(ctrls->AxiDma, XAXIDMA_IRQ_IOC_MASK | XAXIDMA_IRQ_ERROR_MASK, XAXIDMA_DMA_TO_DEVICE);
+	//Enable IOC and error interrupts for device to DMA (DMA write/S2MM)
+	if(ctrls->CfgPtr->HasS2Mm) {
+		XAxiDma_IntrEnable(ctrls->AxiDma, XAXIDMA_IRQ_IOC_MASK | XAXIDMA_IRQ_ERROR_MASK, XAXIDMA_DEVICE_TO_DMA);
+	}
 
 	//Enable interrupts from GIC to PS
     //Xil_ExceptionInit();	this function does nothing!
@@ -207,37 +275,471 @@ void enableInterrupts(controllers *ctrls) {
     XScuGic_Enable(ctrls->IntcInstancePtr, VSYNC_INTR_ID);
 	XScuGic_Enable(ctrls->IntcInstancePtr, HSYNC_INTR_ID);
 	XScuGic_Enable(ctrls->IntcInstancePtr, UART_INTR_ID);
+	XScuGic_Enable(ctrls->IntcInstancePtr, MM2S_INTR_ID);
+	XScuGic_Enable(ctrls->IntcInstancePtr, S2MM_INTR_ID);
 }
 
 /*************************************************************
-* dmaReadReg sets the appropriate DMA registers for a read operation MM2S.
+* dmaRoute selects where the MM2S stream goes.
+*
+* @param	loopback is 1 to loop the stream back to S2MM,
+* 			0 to send it to the VGA output.
 *
-* @param	srcAddr is the source address from where to read.
+* @return	None.
+*
+* @note		Does nothing if the hardware design has no stream
+* 			switch select (LOOPBACK_SEL_ADDR).
+*************************************************************/
+static void dmaRoute(u32 loopback) {
+#ifdef LOOPBACK_SEL_ADDR
+	Xil_Out32(LOOPBACK_SEL_ADDR, loopback);
+#else
+	(void) loopback;
+#endif
+}
+
+/*************************************************************
+* dmaBoundaryLength returns how much of a transfer fits before
+* 			the next DMA_BURST_BOUNDARY.
+*
+* @param	addr is the start of the transfer.
+* @param	length is the number of bytes to transfer.
+*
+* @return	Number of bytes up to the boundary, at most length.
+*
+* @note		None.
+*************************************************************/
+static u32 dmaBoundaryLength(void *addr, u32 length) {
+	u32 room = DMA_BURST_BOUNDARY - ((UINTPTR) addr & (DMA_BURST_BOUNDARY - 1));
+
+	return (length < room) ? length : room;
+}
+
+/*************************************************************
+* dmaStart writes the source address and length of a MM2S transfer.
+*
+* @param	srcAddr is the line to read, a framebuffer row or an
+* 			expanded line of an indexed framebuffer.
 * @param	length is the number of bytes to read.
+* @param	ctrls is a pointer to the controllers structure.
+*
+* @return	None.
+*
+* @note		The channel must be idle and running.
+*************************************************************/
+static void dmaStart(u32 *srcAddr, u32 length, controllers *ctrls) {
+	XTime now;
+
+	dmaBusy = 1;
+	channelsLeft = 1;
+	dmaLength = length;
+	XTime_GetTime(&now);
+	dmaStartTime = now;
+	//Write a valid source address to the MM2S_SA register
+	Xil_Out32((UINTPTR) (ctrls->CfgPtr->BaseAddr + XAXIDMA_SRCADDR_OFFSET), (u32) (UINTPTR) srcAddr);
+	//Write the number of bytes to transfer -> this starts the DMA transaction
+	Xil_Out32((UINTPTR) (ctrls->CfgPtr->BaseAddr + XAXIDMA_BUFFLEN_OFFSET), length);
+}
+
+/*************************************************************
+* dmaStartJob starts the next slice of a queued job. Jobs with
+* 			a memory destination run as a loopback copy: S2MM is
+* 			armed first, then MM2S streams the source into it.
+*
+* @param	job is the job to start or resume at jobOffset.
+* @param	ctrls is a pointer to the controllers structure.
+*
+* @return	None.
+*
+* @note		The channel must be idle and running. A job runs in
+* 			slices of at most DMA_JOB_SLICE bytes, so a long copy
+* 			does not hold back the scanout lines queued meanwhile.
+* 			Slices end at the next DMA_BURST_BOUNDARY of the
+* 			source and of the destination.
+*************************************************************/
+static void dmaStartJob(dmaJob *job, controllers *ctrls) {
+	UINTPTR s2mmBase = ctrls->CfgPtr->BaseAddr + XAXIDMA_RX_OFFSET;
+
+	activeJob = job;
+	sliceLength = job->length - jobOffset;
+	if(sliceLength > DMA_JOB_SLICE) sliceLength = DMA_JOB_SLICE;
+	sliceLength = dmaBoundaryLength((u8 *) job->src + jobOffset, sliceLength);
+	if(job->dst) sliceLength = dmaBoundaryLength((u8 *) job->dst + jobOffset, sliceLength);
+	if(job->dst) {
+		dmaRoute(1);
+		Xil_Out32(s2mmBase + XAXIDMA_DESTADDR_OFFSET, (u32) (UINTPTR) ((u8 *) job->dst + jobOffset));
+		Xil_Out32(s2mmBase + XAXIDMA_BUFFLEN_OFFSET, sliceLength);
+	}
+	dmaStart((u32 *) ((u8 *) job->src + jobOffset), sliceLength, ctrls);
+	if(job->dst) channelsLeft = 2;
+}
+
+/*************************************************************
+* dmaNext starts the pending scanout line or else the rest of
+* 			a suspended job or the next queued job, if any.
+*
+* @param	ctrls is a pointer to the controllers structure.
+*
+* @return	None.
+*
+* @note		The channel must be idle.
+*************************************************************/
+static void dmaNext(controllers *ctrls) {
+	if(pendingTail != pendingHead) {
+		u32 slot = pendingTail % SCAN_QUEUE_SIZE;
+		activeJob = NULL;
+		dmaStart(pendingLines[slot], pendingLength[slot], ctrls);
+		pendingTail++;
+		mm2sStats.queued++;
+	} else if(suspendedJob) {
+		dmaJob *job = suspendedJob;
+		suspendedJob = NULL;
+		dmaStartJob(job, ctrls);
+	} else {
+		dmaJob *job = dmaQueuePop();
+		if(job) {
+			dmaStartJob(job, ctrls);
+			mm2sStats.queued++;
+		}
+	}
+}
+
+/*************************************************************
+* dmaComplete finishes a transfer once all of its channels are
+* 			done. It records the latency, calls the callback of a
+* 			queued job and starts the next transfer.
+*
+* @param	ctrls is a pointer to the controllers structure.
+*
+* @return	None.
+*
+* @note		Called from the MM2S and S2MM completion interrupts,
+* 			which share a priority and so never nest.
+*************************************************************/
+static void dmaComplete(controllers *ctrls) {
+	XTime now, latency;
+
+	//Record the latency of the finished transfer
+	XTime_GetTime(&now);
+	latency = now - dmaStartTime;
+	mm2sStats.transfers++;
+	mm2sStats.bytes += dmaLength;
+	mm2sStats.lastLatency = latency;
+	mm2sStats.totalLatency += latency;
+	if(latency < mm2sStats.minLatency) mm2sStats.minLatency = latency;
+	if(latency > mm2sStats.maxLatency) mm2sStats.maxLatency = latency;
+	dmaBusy = 0;
+
+	//Finish the queued job once its last slice is done, its callback runs here
+	if(activeJob) {
+		if(activeJob->dst) dmaRoute(0);
+		jobOffset += sliceLength;
+		jobTime += latency;
+		if(jobOffset < activeJob->length) suspendedJob = activeJob;
+		else {
+			//Drop lines the CPU may have speculatively fetched during the copy
+			if(activeJob->dst && !(activeJob->flags & DMA_FLAG_NO_INVALIDATE)) {
+				Xil_DCacheInvalidateRange((INTPTR) activeJob->dst, activeJob->length);
+			}
+			dmaQueueFinish(activeJob, jobTime, XST_SUCCESS);
+			jobOffset = 0;
+			jobTime = 0;
+		}
+		activeJob = NULL;
+	}
+
+	//Immediately queue the next pending transfer, scanout first
+	dmaNext(ctrls);
+}
+
+/*************************************************************
+* countErrors counts the error bits of a channel status register.
+*
+* @param	status is the value of the status register.
+*
+* @return	None.
+*
+* @note		None.
+*************************************************************/
+static void countErrors(u32 status) {
+	if(status & XAXIDMA_ERR_INTERNAL_MASK) dmaErrorStats.internal++;
+	if(status & XAXIDMA_ERR_SLAVE_MASK) dmaErrorStats.slave++;
+	if(status & XAXIDMA_ERR_DECODE_MASK) dmaErrorStats.decode++;
+	if(status & XAXIDMA_ERR_SG_INT_MASK) dmaErrorStats.sgInternal++;
+	if(status & XAXIDMA_ERR_SG_SLV_MASK) dmaErrorStats.sgSlave++;
+	if(status & XAXIDMA_ERR_SG_DEC_MASK) dmaErrorStats.sgDecode++;
+	if(!(status & XAXIDMA_ERR_ALL_MASK)) dmaErrorStats.halted++;
+}
+
+/*************************************************************
+* dmaReset soft resets the DMA, drops the scanout lines and jobs
+* 			in flight and re-arms both channels.
+*
+* @param	ctrls is a pointer to the controllers structure.
+*
+* @return	None.
+*
+* @note		The reset clears both channels, so a running job fails
+* 			and its callback gets XST_FAILURE. The MM2S channel of
+* 			the SG engine is left halted for its descriptors.
+*************************************************************/
+static void dmaReset(controllers *ctrls) {
+	UINTPTR base = ctrls->CfgPtr->BaseAddr;
+	u32 timeout = DMA_RESET_TIMEOUT;
+
+	//Soft reset of the whole DMA
+	Xil_Out32(base + XAXIDMA_TX_OFFSET + XAXIDMA_CR_OFFSET, XAXIDMA_CR_RESET_MASK);
+	while((Xil_In32(base + XAXIDMA_TX_OFFSET + XAXIDMA_CR_OFFSET) & XAXIDMA_CR_RESET_MASK) && --timeout);
+	if(!timeout) dmaErrorStats.failedResets++;
+
+	//Fail the job that was running or suspended and drop the scanout lines of the old pipeline
+	if(!activeJob) activeJob = suspendedJob;
+	if(activeJob) {
+		if(activeJob->dst) dmaRoute(0);
+		dmaQueueFinish(activeJob, 0, XST_FAILURE);
+		activeJob = NULL;
+	}
+	suspendedJob = NULL;
+	jobOffset = 0;
+	jobTime = 0;
+	pendingTail = pendingHead;
+	dmaBusy = 0;
+	channelsLeft = 0;
+
+	//Re-arm both channels with their interrupts
+	if(ctrls->CfgPtr->HasS2Mm) {
+		Xil_Out32(base + XAXIDMA_RX_OFFSET + XAXIDMA_CR_OFFSET,
+				XAXIDMA_CR_RUNSTOP_MASK | XAXIDMA_IRQ_IOC_MASK | XAXIDMA_IRQ_ERROR_MASK);
+	}
+	if(XAxiDma_HasSg(ctrls->AxiDma)) {
+		Xil_Out32(base + XAXIDMA_TX_OFFSET + XAXIDMA_CR_OFFSET, XAXIDMA_IRQ_ERROR_MASK);
+	} else {
+		Xil_Out32(base + XAXIDMA_TX_OFFSET + XAXIDMA_CR_OFFSET,
+				XAXIDMA_CR_RUNSTOP_MASK | XAXIDMA_IRQ_IOC_MASK | XAXIDMA_IRQ_ERROR_MASK);
+	}
+}
+
+/*************************************************************
+* dmaRecover resets the DMA after an error or an unexpected halt,
+* 			re-arms its channels and resumes the scanout at the
+* 			line of the beam.
+*
+* @param	ctrls is a pointer to the controllers structure.
+*
+* @return	None.
+*
+* @note		The reset clears both channels, so a running job fails
+* 			and its callback gets XST_FAILURE. In SG mode the frame
+* 			in flight is lost and scanout resumes on the next VSync.
+* 			Called from the completion handlers, or with their
+* 			interrupts disabled.
+*************************************************************/
+static void dmaRecover(controllers *ctrls) {
+	UINTPTR base = ctrls->CfgPtr->BaseAddr;
+	XTime start, end;
+	u32 s2mmStatus = 0;
+
+	XTime_GetTime(&start);
+	countErrors(Xil_In32(base + XAXIDMA_TX_OFFSET + XAXIDMA_SR_OFFSET));
+	if(ctrls->CfgPtr->HasS2Mm) s2mmStatus = Xil_In32(base + XAXIDMA_RX_OFFSET + XAXIDMA_SR_OFFSET);
+	if(s2mmStatus & XAXIDMA_ERR_ALL_MASK) countErrors(s2mmStatus);
+
+	dmaReset(ctrls);
+	dmaErrorStats.resets++;
+
+	if(XAxiDma_HasSg(ctrls->AxiDma)) {
+		sgRingRestart(&scanoutRing);
+	} else {
+		//Queue the lines from the beam on, within the same frame
+		prefetchResume(lineIndex);
+		prefetchLines(lineIndex);
+	}
+
+	XTime_GetTime(&end);
+	dmaErrorStats.lastRecovery = end - start;
+	if(dmaErrorStats.lastRecovery > dmaErrorStats.maxRecovery) dmaErrorStats.maxRecovery = dmaErrorStats.lastRecovery;
+}
+
+/*************************************************************
+* restartScanout resets the DMA and starts the scanout over with
+* 			the geometry of the current display mode.
+*
+* @param	ctrls is a pointer to the controllers structure.
+*
+* @return
+* 			- XST_SUCCESS if successful,
+* 			- XST_FAILURE if the descriptor ring can not be built.
+*
+* @note		Called by setDisplayMode with HSync and VSync disabled,
+* 			the first lines are queued on the next VSync. The
+* 			completion interrupts are disabled too until the ring
+* 			is rebuilt, so they see neither a half reset DMA nor a
+* 			half built ring. In SG mode the descriptor ring is set
+* 			up again for the new frame size. A compressed frame has
+* 			the size of the old mode, the framebuffers are shown
+* 			again.
+*************************************************************/
+int restartScanout(controllers *ctrls) {
+	int Status = XST_SUCCESS;
+
+	XScuGic_Disable(ctrls->IntcInstancePtr, MM2S_INTR_ID);
+	XScuGic_Disable(ctrls->IntcInstancePtr, S2MM_INTR_ID);
+	dmaReset(ctrls);
+	lineIndex = FIRST_LINE;
+	prefetchRestart();
+	showRleFrame(NULL);
+	flipRleFrame();
+	if(XAxiDma_HasSg(ctrls->AxiDma)) {
+		Status = sgRingInit(&scanoutRing, ctrls->CfgPtr->BaseAddr + XAXIDMA_TX_OFFSET, SG_ROWS_PER_BD);
+	}
+	XScuGic_Enable(ctrls->IntcInstancePtr, S2MM_INTR_ID);
+	XScuGic_Enable(ctrls->IntcInstancePtr, MM2S_INTR_ID);
+
+	return Status;
+}
+
+/*************************************************************
+* dmaGetErrors copies the DMA error counters.
+*
+* @param	errors is where to copy the counters to.
+*
+* @return	None.
+*
+* @note		None.
+*************************************************************/
+void dmaGetErrors(dmaErrors *errors) {
+	*errors = dmaErrorStats;
+}
+
+/*************************************************************
+* dmaReadReg sets the appropriate DMA registers for a read operation MM2S.
+*
+* @param	srcAddr is the line to read, a framebuffer row or an
+* 			expanded line of an indexed framebuffer.
+* @param	length is the number of pixels to read.
 * @param	ctrls is a pointer to the controllers structure which
 * 			holds necessary configuration and instance variables
 * 			for initialization.
 *
 * @return
-* 			- XST_SUCCESS if successful,
-* 			- XST_FAILURE otherwise.
+* 			- DMA_READ_STARTED if the transfer was started,
+* 			- DMA_READ_QUEUED if it was queued for MM2SIntrHandler,
+* 			- DMA_READ_DROPPED if the line queue is full.
+*
+* @note		Never waits. If the channel is still busy, the transfer
+* 			is queued in order and started by the completion interrupt.
+* 			A line crossing DMA_BURST_BOUNDARY goes as two transfers,
+* 			queued together or dropped together.
+*************************************************************/
+dmaReadStatus dmaReadReg(void *srcAddr, u32 length, controllers *ctrls) {
+	dmaReadStatus Status = DMA_READ_QUEUED;
+	u8 *src = (u8 *) srcAddr;
+	u32 bytes = length * SCAN_BYTES_PER_PIXEL;
+	u32 parts = 0;
+
+	for(u32 offset = 0; offset < bytes; parts++) offset += dmaBoundaryLength(src + offset, bytes - offset);
+
+	//The completion interrupts must not run between the check and the start
+	XScuGic_Disable(ctrls->IntcInstancePtr, MM2S_INTR_ID);
+	XScuGic_Disable(ctrls->IntcInstancePtr, S2MM_INTR_ID);
+	//An idle channel takes the first part, the others need room in the queue
+	if(pendingHead - pendingTail + parts - !dmaBusy > SCAN_QUEUE_SIZE) {
+		mm2sStats.dropped++;
+		Status = DMA_READ_DROPPED;
+		bytes = 0;
+	}
+	while(bytes) {
+		u32 part = dmaBoundaryLength(src, bytes);
+		if(dmaBusy) {
+			pendingLines[pendingHead % SCAN_QUEUE_SIZE] = (u32 *) src;
+			pendingLength[pendingHead % SCAN_QUEUE_SIZE] = part;
+			pendingHead++;
+		} else {
+			activeJob = NULL;
+			dmaStart((u32 *) src, part, ctrls);
+			Status = DMA_READ_STARTED;
+		}
+		src += part;
+		bytes -= part;
+	}
+	XScuGic_Enable(ctrls->IntcInstancePtr, S2MM_INTR_ID);
+	XScuGic_Enable(ctrls->IntcInstancePtr, MM2S_INTR_ID);
+
+	return Status;
+}
+
+/*************************************************************
+* dmaPendingLines returns the number of scanout lines waiting for
+* 			the MM2S channel.
+*
+* @param	None.
+*
+* @return	Number of waiting lines.
 *
 * @note		None.
 *************************************************************/
-int dmaReadReg(u32 *srcAddr, u32 length, controllers *ctrls) {
-	//Setting DMA MM2S run/stop bit to 1
-	Xil_Out32((ctrls->CfgPtr->BaseAddr + XAXIDMA_CR_OFFSET), XAXIDMA_CR_RUNSTOP_MASK);
-	//Write a valid source address to the MM2S_SA register
-	Xil_Out32((UINTPTR) (ctrls->CfgPtr->BaseAddr + XAXIDMA_SRCADDR_OFFSET), (u32) srcAddr);
-	//Write the number of bytes to transfer -> this starts the DMA transaction
-	Xil_Out32((UINTPTR) (ctrls->CfgPtr->BaseAddr + XAXIDMA_BUFFLEN_OFFSET), length * 4);
+u32 dmaPendingLines(void) {
+	return pendingHead - pendingTail;
+}
 
-	//Check if transmit is (not) done -> usleep
-	//instead of waiting in this function an interrupt will be called when transfer is complete
-	if(!(Xil_In32(ctrls->CfgPtr->BaseAddr + XAXIDMA_SR_OFFSET) & 0x2)) {
-		usleep(1);
+/*************************************************************
+* dmaKick starts the next queued DMA job if the channel is idle.
+*
+* @param	ctrls is a pointer to the controllers structure which
+* 			holds necessary configuration and instance variables
+* 			for initialization.
+*
+* @return	None.
+*
+* @note		Pending scanout lines always go before queued jobs,
+* 			those are started from MM2SIntrHandler.
+*************************************************************/
+void dmaKick(controllers *ctrls) {
+	XScuGic_Disable(ctrls->IntcInstancePtr, MM2S_INTR_ID);
+	XScuGic_Disable(ctrls->IntcInstancePtr, S2MM_INTR_ID);
+	if(!dmaBusy && !XAxiDma_HasSg(ctrls->AxiDma)) {
+		dmaJob *job = dmaQueuePop();
+		if(job) dmaStartJob(job, ctrls);
 	}
-	return XST_SUCCESS;
+	XScuGic_Enable(ctrls->IntcInstancePtr, S2MM_INTR_ID);
+	XScuGic_Enable(ctrls->IntcInstancePtr, MM2S_INTR_ID);
+}
+
+/*************************************************************
+* resetIsrStats clears the HSync and VSync handler timings.
+*
+* @param	None.
+*
+* @return	None.
+*
+* @note		None.
+*************************************************************/
+void resetIsrStats(void) {
+	XScuGic_Disable(ctrls->IntcInstancePtr, HSYNC_INTR_ID);
+	XScuGic_Disable(ctrls->IntcInstancePtr, VSYNC_INTR_ID);
+	hsyncStats = (isrStats) {0, 0, 0};
+	vsyncStats = (isrStats) {0, 0, 0};
+	XScuGic_Enable(ctrls->IntcInstancePtr, VSYNC_INTR_ID);
+	XScuGic_Enable(ctrls->IntcInstancePtr, HSYNC_INTR_ID);
+}
+
+/*************************************************************
+* isrStatsAdd adds a run of a handler to its timings.
+*
+* @param	stats is the timings of the handler.
+* @param	start is the global timer at the start of the run.
+*
+* @return	None.
+*
+* @note		None.
+*************************************************************/
+static void isrStatsAdd(volatile isrStats *stats, XTime start) {
+	XTime end;
+
+	XTime_GetTime(&end);
+	stats->calls++;
+	stats->totalTime += end - start;
+	if(end - start > stats->maxTime) stats->maxTime = end - start;
 }
 
 /*************************************************************
@@ -248,21 +750,25 @@ int dmaReadReg(u32 *srcAddr, u32 length, controllers *ctrls) {
 *
 * @return	None.
 *
-* @note		None.
+* @note		Its run time is kept in hsyncStats.
 *************************************************************/
 void HSyncIntrHandler(void *Callback) {
+	XTime start;
+
+	(void) Callback;
+	XTime_GetTime(&start);
 	//Disable the interrupt
 	XScuGic_Disable(ctrls->IntcInstancePtr, HSYNC_INTR_ID);
 
-	//Do some data transfer
-	dmaReadReg(vgaArray[lineIndex], SCREEN_WIDTH, ctrls);
-	Xil_DCacheFlushRange((INTPTR) vgaArray[(lineIndex+1)%SCREEN_HEIGHT], SCREEN_WIDTH*4);
+	//Do some data transfer, keeping the configured number of lines queued ahead
+	prefetchLines(lineIndex);
 
-	//Sending 600 lines, then starting over
-	if(lineIndex<(SCREEN_HEIGHT - 1))lineIndex++;
+	//Sending the lines of the frame, then starting over
+	if(lineIndex<(SCAN_HEIGHT - 1))lineIndex++;
 
 	//End of data transfer, enable the interrupt
 	XScuGic_Enable(ctrls->IntcInstancePtr, HSYNC_INTR_ID);
+	isrStatsAdd(&hsyncStats, start);
 }
 
 /*************************************************************
@@ -273,16 +779,100 @@ void HSyncIntrHandler(void *Callback) {
 *
 * @return	None.
 *
-* @note		None.
+* @note		Its run time is kept in vsyncStats.
 *************************************************************/
 void VSyncIntrHandler(void *Callback) {
+	XTime start;
 
+	(void) Callback;
+	XTime_GetTime(&start);
 	XScuGic_Disable(ctrls->IntcInstancePtr, VSYNC_INTR_ID);
 
  	//Reset the line index
- 	lineIndex = -28;
+ 	lineIndex = FIRST_LINE;
+ 	prefetchRestart();
+
+ 	//Page flip to the queued frame, if any, and to the compressed frame asked for
+ 	flipFramebuffers();
+ 	flipRleFrame();
+
+ 	//Palette animations change colors between frames, before the first line is expanded
+ 	updatePaletteAnimations();
+
+ 	//A halted MM2S channel blanks the screen, reset it once per frame at the latest,
+ 	//the completion interrupts preempt VSync and must not see a half reset DMA
+ 	XScuGic_Disable(ctrls->IntcInstancePtr, MM2S_INTR_ID);
+ 	XScuGic_Disable(ctrls->IntcInstancePtr, S2MM_INTR_ID);
+ 	if(Xil_In32(ctrls->CfgPtr->BaseAddr + XAXIDMA_SR_OFFSET) & XAXIDMA_HALTED_MASK) dmaRecover(ctrls);
+ 	XScuGic_Enable(ctrls->IntcInstancePtr, S2MM_INTR_ID);
+ 	XScuGic_Enable(ctrls->IntcInstancePtr, MM2S_INTR_ID);
+
+ 	//In SG mode flush the rows written since the frame was last shown and
+ 	//hand it to the DMA with a single tail pointer write
+ 	if(XAxiDma_HasSg(ctrls->AxiDma)) {
+ 		flushScanoutFrame();
+ 		sgRingSubmitFrame(&scanoutRing, scanoutLineRows);
+ 	}
 
  	XScuGic_Enable(ctrls->IntcInstancePtr, VSYNC_INTR_ID);
+ 	isrStatsAdd(&vsyncStats, start);
+}
+
+/*************************************************************
+* MM2SIntrHandler is the DMA MM2S completion interrupt handler.
+* 			It acknowledges the interrupt and completes the
+* 			transfer unless a loopback copy still waits for S2MM.
+*
+* @param	Callback is a pointer to the caller, in this case
+* 			to the interrupt controller.
+*
+* @return	None.
+*
+* @note		Latencies are measured in global timer ticks,
+* 			COUNTS_PER_SECOND per second.
+*************************************************************/
+void MM2SIntrHandler(void *Callback) {
+	u32 irqStatus = XAxiDma_IntrGetIrq(ctrls->AxiDma, XAXIDMA_DMA_TO_DEVICE);
+
+	(void) Callback;
+	//Acknowledge the interrupt
+	XAxiDma_IntrAckIrq(ctrls->AxiDma, irqStatus, XAXIDMA_DMA_TO_DEVICE);
+	//An error halts the channel, reset and resume
+	if(irqStatus & XAXIDMA_IRQ_ERROR_MASK) {
+		dmaRecover(ctrls);
+		return;
+	}
+	//Only simple mode transfers started by dmaStart are timed
+	if(!(irqStatus & XAXIDMA_IRQ_IOC_MASK) || !dmaBusy) return;
+
+	if(--channelsLeft == 0) dmaComplete(ctrls);
+}
+
+/*************************************************************
+* S2MMIntrHandler is the DMA S2MM completion interrupt handler.
+* 			It acknowledges the interrupt and completes the
+* 			loopback copy unless MM2S is still running.
+*
+* @param	Callback is a pointer to the caller, in this case
+* 			to the interrupt controller.
+*
+* @return	None.
+*
+* @note		None.
+*************************************************************/
+void S2MMIntrHandler(void *Callback) {
+	u32 irqStatus = XAxiDma_IntrGetIrq(ctrls->AxiDma, XAXIDMA_DEVICE_TO_DMA);
+
+	(void) Callback;
+	//Acknowledge the interrupt
+	XAxiDma_IntrAckIrq(ctrls->AxiDma, irqStatus, XAXIDMA_DEVICE_TO_DMA);
+	if(irqStatus & XAXIDMA_IRQ_ERROR_MASK) {
+		dmaRecover(ctrls);
+		return;
+	}
+	if(!(irqStatus & XAXIDMA_IRQ_IOC_MASK) || !dmaBusy) return;
+
+	if(--channelsLeft == 0) dmaComplete(ctrls);
 }
 
 /*************************************************************
@@ -5,7 +5,7 @@
 *
 * Author: Ahac Rafael Bela
 * Created on: 01.03.2025
-* Last modified: 10.04.2025
+* Last modified: 17.05.2025
 *************************************************************/
 //Protection macro
 #pragma once
@@ -24,6 +24,8 @@
 #include "xil_exception.h"
 //Cache library
 #include "xil_cache.h"
+//Global timer library
+#include "xtime_l.h"
 //Debug library
 #include "xdebug.h"
 //Interrupt controller library
@@ -40,11 +42,78 @@
 /*************************************************************
 * Macro section
 *************************************************************/
-#define SCREEN_WIDTH  800
-#define SCREEN_HEIGHT 600
+//Largest display mode, the framebuffers are allocated for it
+#define SCREEN_MAX_WIDTH	800
+#define SCREEN_MAX_HEIGHT	600
+//Visible size of the selected display mode, signed like the coordinates it is compared with
+#define SCREEN_WIDTH	((s32) currentMode->width)
+#define SCREEN_HEIGHT	((s32) currentMode->height)
+//Pixel repeat of the selected display mode, the scanout sends each framebuffer pixel
+//SCREEN_SCALE times across and each row on SCREEN_SCALE lines
+#define SCREEN_SCALE	((s32) currentMode->scale)
+//Visible pixels per line and lines per frame the scanout sends
+#define SCAN_WIDTH		(SCREEN_WIDTH * SCREEN_SCALE)
+#define SCAN_HEIGHT		(SCREEN_HEIGHT * SCREEN_SCALE)
+//AXI bursts must not cross this boundary, DMA transfers are split at it
+#define DMA_BURST_BOUNDARY	4096
+//Pixel formats of the framebuffer. The direct formats are sent to the VGA output as they
+//are stored, so the hardware design must take the same one. Indexed formats hold palette
+//indices, the first pixel in the lowest bits of a byte, and are expanded to XRGB8888 lines
+//ahead of the beam
+#define FB_FORMAT_XRGB8888	0	//32 bits, red in the low byte, top byte unused
+#define FB_FORMAT_RGB565	1	//16 bits, red in bits 0-4, green in 5-10, blue in 11-15
+#define FB_FORMAT_INDEX8	2	//8 bit palette indices
+#define FB_FORMAT_INDEX4	3	//4 bit palette indices, two pixels per byte
+#define FB_FORMAT_INDEX1	4	//1 bit palette indices, eight pixels per byte
+#ifndef FB_FORMAT
+#define FB_FORMAT		FB_FORMAT_XRGB8888
+#endif
+#if FB_FORMAT == FB_FORMAT_XRGB8888
+#define FB_BITS_PER_PIXEL	32
+#elif FB_FORMAT == FB_FORMAT_RGB565
+#define FB_BITS_PER_PIXEL	16
+#elif FB_FORMAT == FB_FORMAT_INDEX8
+#define FB_BITS_PER_PIXEL	8
+#elif FB_FORMAT == FB_FORMAT_INDEX4
+#define FB_BITS_PER_PIXEL	4
+#elif FB_FORMAT == FB_FORMAT_INDEX1
+#define FB_BITS_PER_PIXEL	1
+#else
+#error "Unknown FB_FORMAT"
+#endif
+#define FB_INDEXED		(FB_FORMAT >= FB_FORMAT_INDEX8)
+//Bytes of one visible framebuffer row, in the selected and in the largest mode
+#define FB_LINE_BYTES		(SCREEN_WIDTH * FB_BITS_PER_PIXEL / 8)
+#define FB_MAX_LINE_BYTES	(SCREEN_MAX_WIDTH * FB_BITS_PER_PIXEL / 8)
+//Bytes per pixel and per line of the stream sent to the VGA output
+#define SCAN_BYTES_PER_PIXEL	((FB_FORMAT == FB_FORMAT_RGB565) ? 2 : 4)
+#define SCAN_LINE_BYTES		(SCAN_WIDTH * SCAN_BYTES_PER_PIXEL)
+//Framebuffer rows of b bytes are padded to a multiple of FB_ROW_ALIGN(b) bytes. The default,
+//the smallest power of 2 that holds a row, keeps every row inside one DMA_BURST_BOUNDARY,
+//FB_PITCH_ALIGN 64 (a burst) leaves them unpadded. Indexed rows are read by the CPU and
+//only padded to whole words like SURFACE_PITCH, the DMA reads their expanded lines
+#ifdef FB_PITCH_ALIGN
+#define FB_ROW_ALIGN(b)		FB_PITCH_ALIGN
+#elif FB_INDEXED
+#define FB_ROW_ALIGN(b)		4
+#else
+#define FB_ROW_ALIGN(b)		((b) <= 128 ? 128 : (b) <= 256 ? 256 : (b) <= 512 ? 512 : \
+							(b) <= 1024 ? 1024 : (b) <= 2048 ? 2048 : DMA_BURST_BOUNDARY)
+#endif
+#define FB_PITCH_FOR(b)		(((b) + FB_ROW_ALIGN(b) - 1) / FB_ROW_ALIGN(b) * FB_ROW_ALIGN(b))
+//Bytes and pixel storage units from the start of one framebuffer row to the next
+#define FB_PITCH		(currentMode->pitch)
+#define FB_MAX_PITCH	FB_PITCH_FOR(FB_MAX_LINE_BYTES)
+#define FB_STRIDE		(FB_PITCH / sizeof(pixel))
+//Start of row y of a framebuffer
+#define FB_ROW(fb, y)	((pixel *) ((u8 *) (fb) + (s32) (y) * (s32) FB_PITCH))
+//Clip rectangles a surface holds at the same time
+#define SURFACE_CLIP_DEPTH	4
 //DMA interrupts
 #define XPAR_FABRIC_HSYNC_INTROUT_VEC_ID 63U
 #define XPAR_FABRIC_VSYNC_INTROUT_VEC_ID 64U
+#define XPAR_FABRIC_MM2S_INTROUT_VEC_ID  61U
+#define XPAR_FABRIC_S2MM_INTROUT_VEC_ID  62U
 
 /*************************************************************
 * Interrupt section
@@ -52,6 +121,8 @@
 #define HSYNC_INTR_ID   XPAR_FABRIC_HSYNC_INTROUT_VEC_ID
 #define VSYNC_INTR_ID   XPAR_FABRIC_VSYNC_INTROUT_VEC_ID
 #define UART_INTR_ID	XPAR_XUARTPS_1_INTR
+#define MM2S_INTR_ID	XPAR_FABRIC_MM2S_INTROUT_VEC_ID
+#define S2MM_INTR_ID	XPAR_FABRIC_S2MM_INTROUT_VEC_ID
 
 /*************************************************************
 * Device section
@@ -67,10 +138,43 @@
 
 #define UART_RX_BUFFER	(XPAR_PS7_DDR_0_S_AXI_HIGHADDR - 0xFFF)
 
+//Width of the buffer length register as configured in the hardware design
+#define DMA_LENGTH_WIDTH	23
+#define DMA_MAX_LENGTH		((1U << DMA_LENGTH_WIDTH) - 1)
+//Number of scanout lines that can wait for the MM2S channel, must be a power of 2
+#define SCAN_QUEUE_SIZE		16
+//Largest part of a queued job run at once, scanout lines queued meanwhile go in between
+#define DMA_JOB_SLICE		4096
+//Most status register polls while waiting for a DMA reset to finish
+#define DMA_RESET_TIMEOUT	1000
+
+//MM2S stream routing, selects loopback to S2MM instead of the VGA output
+#ifdef XPAR_AXI_GPIO_0_BASEADDR
+#define LOOPBACK_SEL_ADDR	XPAR_AXI_GPIO_0_BASEADDR
+#endif
+//Optional VGA timing generator mode select, takes the index of a display mode and restarts
+//the frame. Without it the hardware only generates the timing of DISPLAY_MODE
+#ifdef XPAR_AXI_GPIO_1_BASEADDR
+#define DISPLAY_MODE_SEL_ADDR	XPAR_AXI_GPIO_1_BASEADDR
+#endif
+
 #ifndef DEBUG
 extern void xil_printf(const char *format, ...);
 #endif
 
+/*************************************************************
+* Type section
+*************************************************************/
+//Storage unit of a framebuffer row, one pixel in the direct formats and one
+//byte of palette indices in the indexed formats
+#if FB_FORMAT == FB_FORMAT_XRGB8888
+typedef u32 pixel;
+#elif FB_FORMAT == FB_FORMAT_RGB565
+typedef u16 pixel;
+#else
+typedef u8 pixel;
+#endif
+
 /*************************************************************
 * Struct section
 *************************************************************/
@@ -83,18 +187,104 @@ typedef struct controllers_t {
 	XUartPs_Config *Cfg;		//Pointer to the config of UartPs
 } controllers;
 
+typedef struct dmaStats_t {
+	u32 transfers;			//Number of completed transfers
+	u32 queued;				//Number of transfers started from the completion interrupt
+	u32 dropped;			//Number of scanout lines dropped because the line queue was full
+	XTime lastLatency;		//Latency of the last transfer in global timer ticks
+	XTime minLatency;		//Shortest latency in global timer ticks
+	XTime maxLatency;		//Longest latency in global timer ticks
+	XTime totalLatency;		//Sum of all latencies in global timer ticks
+	u64 bytes;				//Bytes moved by the completed transfers
+} dmaStats;
+
+typedef struct dmaErrors_t {
+	u32 internal;			//DMAIntErr, e.g. a zero length transfer
+	u32 slave;				//DMASlvErr, slave error on the memory interface
+	u32 decode;				//DMADecErr, address decode error
+	u32 sgInternal;			//SGIntErr, descriptor already marked complete
+	u32 sgSlave;			//SGSlvErr, slave error while fetching a descriptor
+	u32 sgDecode;			//SGDecErr, descriptor address decode error
+	u32 halted;				//Engine found halted without an error interrupt
+	u32 resets;				//Number of channel resets done
+	u32 failedResets;		//Number of resets that did not finish in time
+	XTime lastRecovery;		//Duration of the last recovery in global timer ticks
+	XTime maxRecovery;		//Longest recovery in global timer ticks
+} dmaErrors;
+
+typedef struct isrStats_t {
+	u32 calls;				//Number of times the handler ran
+	XTime totalTime;		//Time spent in the handler in global timer ticks
+	XTime maxTime;			//Longest run of the handler in global timer ticks
+} isrStats;
+
+typedef struct displayMode_t {
+	const char *name;		//Name printed on the UART
+	u32 width;				//Visible pixels per line
+	u32 height;				//Rows of the framebuffer
+	u32 scale;				//Pixel repeat, the visible size is width x height times scale
+	u32 pixelClock;			//Pixel clock in Hz
+	u32 hFrontPorch;		//Pixel clocks from the end of the visible line to the HSync pulse
+	u32 hSync;				//Pixel clocks of the HSync pulse
+	u32 hBackPorch;			//Pixel clocks from the HSync pulse to the next visible line
+	u32 vFrontPorch;		//Lines from the end of the frame to the VSync pulse
+	u32 vSync;				//Lines of the VSync pulse
+	u32 vBackPorch;			//Lines from the VSync pulse to the first visible line
+	u32 pitch;				//Bytes from the start of one framebuffer row to the next
+	u32 format;				//Pixel format of the framebuffer, FB_FORMAT_*
+} displayMode;
+
+//Rectangle of pixels, both corners are inside it
+typedef struct rect_t {
+	s32 x0, y0;				//Top left corner
+	s32 x1, y1;				//Bottom right corner, empty if left of or above the top left one
+} rect;
+
+//Image the drawing functions render to, the screen or an offscreen buffer
+typedef struct surface_t {
+	pixel *base;			//First pixel of the top row
+	u32 width;				//Visible pixels per row
+	u32 height;				//Rows
+	u32 pitch;				//Bytes from the start of one row to the next
+	u32 format;				//Pixel format, FB_FORMAT_*
+	u32 clipDepth;			//Clip rectangles pushed, with none the whole surface is drawn to
+	rect clips[SURFACE_CLIP_DEPTH];	//Pushed clip rectangles, each one inside the one before
+} surface;
+
 typedef struct point_t {
 	int x;
 	int y;
 } point;
 
+//How the pixels drawn to a surface are combined with the pixels under them,
+//the palette indices with indexed framebuffers
+typedef enum rasterOp_t {
+	ROP_COPY,				//Replaces them
+	ROP_XOR,				//Flips their bits set in the color, drawing twice restores them
+	ROP_OR,					//Sets their bits set in the color
+	ROP_AND					//Clears their bits clear in the color
+} rasterOp;
+
+//What became of a scanout line handed to the MM2S channel
+typedef enum dmaReadStatus_t {
+	DMA_READ_STARTED,		//Its first part went to the channel, the rest is queued
+	DMA_READ_QUEUED,		//All its parts wait for MM2SIntrHandler
+	DMA_READ_DROPPED		//The line queue had no room for all its parts, none was queued
+} dmaReadStatus;
+
 /*************************************************************
 * Variable declaration section
 *************************************************************/
 extern controllers *ctrls;
-extern u32 vgaArray[SCREEN_HEIGHT][SCREEN_WIDTH];
+extern const displayMode *currentMode;
+extern pixel *vgaArray;
+extern pixel *volatile scanoutArray;
 extern volatile u8 caughtChar;
 extern volatile u8 receivedCount;
+extern volatile dmaStats mm2sStats;
+extern volatile dmaErrors dmaErrorStats;
+extern volatile isrStats hsyncStats;
+extern volatile isrStats vsyncStats;
 
 /*************************************************************
 * Function prototype section
@@ -110,7 +300,17 @@ int initInterrupt(controllers *ctrls);
 //Enables interrupts.
 void enableInterrupts(controllers *ctrls);
 //Starts a DMA read operation using corresponding registers.
-int dmaReadReg(u32 *srcAddr, u32 length, controllers *ctrls);
+dmaReadStatus dmaReadReg(void *srcAddr, u32 length, controllers *ctrls);
+//Copies the DMA error counters.
+void dmaGetErrors(dmaErrors *errors);
+//Returns the number of scanout lines waiting for the DMA.
+u32 dmaPendingLines(void);
+//Starts the next queued DMA job if the channel is idle.
+void dmaKick(controllers *ctrls);
+//Clears the HSync and VSync handler timings.
+void resetIsrStats(void);
+//Resets the DMA and starts the scanout over in the current display mode.
+int restartScanout(controllers *ctrls);
 
 /*************************************************************
 * Interrupt service routine section
@@ -119,6 +319,10 @@ int dmaReadReg(u32 *srcAddr, u32 length, controllers *ctrls);
 void HSyncIntrHandler(void *Callback);
 //Vertical synchronization interrupt service routine.
 void VSyncIntrHandler(void *Callback);
+//DMA MM2S completion interrupt service routine.
+void MM2SIntrHandler(void *Callback);
+//DMA S2MM completion interrupt service routine.
+void S2MMIntrHandler(void *Callback);
 //UART Interrupt service routine.
 void UartPsIntrHandler(void *Callback, u32 Event, u32 EventData);
 
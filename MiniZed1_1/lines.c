@@ -5,7 +5,7 @@
 *
 * Author: Ahac Rafael Bela
 * Created on: 08.04.2025
-* Last modified: 10.04.2025
+* Last modified: 17.05.2025
 *************************************************************/
 
 /*************************************************************
@@ -18,76 +18,229 @@
 *************************************************************/
 //Moving speeds of two points of a line for each coordinate
 int dx0, dx1, dy0, dy1;
+//All 256 lines are on screen, the oldest one is erased before the next is drawn
+static int full = 0;
 
 /*************************************************************
 * Function definition section
 *************************************************************/
 
+/*************************************************************
+* outCode returns where a point lies outside a clip rectangle.
+*
+* @param	clip is the clip rectangle.
+* @param	p is the point.
+*
+* @return	CLIP_* bits of the sides the point is beyond, 0 if it
+* 			is inside.
+*
+* @note		None.
+*************************************************************/
+static u32 outCode(rect clip, point p) {
+	u32 code = 0;
+
+	if(p.x < clip.x0) code |= CLIP_LEFT;
+	else if(p.x > clip.x1) code |= CLIP_RIGHT;
+	if(p.y < clip.y0) code |= CLIP_TOP;
+	else if(p.y > clip.y1) code |= CLIP_BOTTOM;
+
+	return code;
+}
+
+/*************************************************************
+* lineAt returns a coordinate of the point of a line a given
+* 			distance along the other axis from its start.
+*
+* @param	from is the coordinate of the start.
+* @param	num is the distance times the slope numerator.
+* @param	den is the slope denominator, not 0.
+*
+* @return	from + num / den, rounded to the nearest pixel.
+*
+* @note		None.
+*************************************************************/
+static s32 lineAt(s32 from, s64 num, s64 den) {
+	if(den < 0) {
+		num = -num;
+		den = -den;
+	}
+	if(num < 0) return from - (s32) ((-2 * num + den) / (2 * den));
+
+	return from + (s32) ((2 * num + den) / (2 * den));
+}
+
+/*************************************************************
+* clipLine cuts a line to the clip rectangle of a surface with
+* 			the Cohen-Sutherland algorithm.
+*
+* @param	dst is the surface the line is drawn to.
+* @param	start is the first point of the line, moved onto the
+* 			edge of the clip rectangle if it is outside.
+* @param	end is the second point of the line, moved like start.
+*
+* @return
+* 			- 1 if part of the line is inside the clip rectangle,
+* 			- 0 if none is.
+*
+* @note		Lines with both points on the outer side of one edge
+* 			are dropped at once. Crossings are worked out from the
+* 			original points in 64 bit, so a clipped line keeps its
+* 			slope and erasing it clears the same pixels.
+*************************************************************/
+int clipLine(const surface *dst, point *start, point *end) {
+	rect clip = getClip(dst);
+	point a = *start, b = *end;
+	s64 dx = b.x - a.x, dy = b.y - a.y;
+	u32 code0 = outCode(clip, a), code1 = outCode(clip, b);
+
+	for(u32 steps = 0; code0 | code1; steps++) {
+		//Both outside one edge, or still outside after every edge it crosses
+		if((code0 & code1) || steps == CLIP_MAX_STEPS) return 0;
+
+		u32 code = code0 ? code0 : code1;
+		point p;
+
+		if(code & CLIP_TOP) p = (point) {lineAt(a.x, dx * (clip.y0 - a.y), dy), clip.y0};
+		else if(code & CLIP_BOTTOM) p = (point) {lineAt(a.x, dx * (clip.y1 - a.y), dy), clip.y1};
+		else if(code & CLIP_LEFT) p = (point) {clip.x0, lineAt(a.y, dy * (clip.x0 - a.x), dx)};
+		else p = (point) {clip.x1, lineAt(a.y, dy * (clip.x1 - a.x), dx)};
+
+		if(code == code0) {
+			*start = p;
+			code0 = outCode(clip, p);
+		} else {
+			*end = p;
+			code1 = outCode(clip, p);
+		}
+	}
+
+	return 1;
+}
+
+/*************************************************************
+* lineRun draws one run of a line along its major axis.
+*
+* @param	dst is the surface to draw to.
+* @param	xMajor is 1 if the run is horizontal, 0 if vertical.
+* @param	across is the row of a horizontal run, the column of a
+* 			vertical one.
+* @param	from is the first pixel of the run along it.
+* @param	to is the last pixel of the run along it.
+* @param	color is the color of the line.
+* @param	op is how the line is combined with the pixels under it.
+*
+* @return	None.
+*
+* @note		None.
+*************************************************************/
+static inline void lineRun(surface *dst, int xMajor, s32 across, s32 from, s32 to, u32 color, rasterOp op) {
+	if(xMajor) hspanOp(dst, across, from, to, color, op);
+	else vspanOp(dst, across, from, to, color, op);
+}
+
+/*************************************************************
+* rasterLine draws a line with the run-slice variant of
+* 			Bresenham's line drawing algorithm.
+*
+* @param	dst is the surface to draw to.
+* @param	start is the first point of the line.
+* @param	end is the second point of the line.
+* @param	color is the color of the line.
+* @param	op is how the line is combined with the pixels under it.
+*
+* @return	None.
+*
+* @note		The line is clipped once, then drawn as one hspan or
+* 			vspan per step along its minor axis instead of one
+* 			pixel at a time. Pixel i along the major axis lies on
+* 			run floor((2 * i * minor + major) / (2 * major)), so
+* 			the run lengths only take the whole and the remainder
+* 			of major / minor, without a branch per pixel. Each
+* 			pixel is drawn once, so ROP_XOR lines are undone by
+* 			drawing them again.
+*************************************************************/
+void rasterLine(surface *dst, point start, point end, u32 color, rasterOp op) {
+	if(!clipLine(dst, &start, &end)) return;
+
+	s32 dx = abs(end.x - start.x), dy = abs(end.y - start.y);
+	int xMajor = dx >= dy;
+	s32 major = xMajor ? dx : dy, minor = xMajor ? dy : dx;
+	//Steps of the runs along the major axis and of the rows or columns across it
+	s32 step = (xMajor ? end.x >= start.x : end.y >= start.y) ? 1 : -1;
+	s32 side = (xMajor ? end.y >= start.y : end.x >= start.x) ? 1 : -1;
+	s32 pos = xMajor ? start.x : start.y, across = xMajor ? start.y : start.x;
+
+	if(minor == 0) {
+		lineRun(dst, xMajor, across, pos, pos + step * major, color, op);
+		return;
+	}
+	//Run k starts at pixel ceil((2k - 1) * major / (2 * minor)), error is how far
+	//the start of the next run is past that fraction, in units of 1 / (2 * minor)
+	s32 whole = major / minor, remainder = 2 * major - whole * 2 * minor;
+	s32 next = (major + 2 * minor - 1) / (2 * minor);
+	s32 error = next * 2 * minor - major;
+
+	for(s32 k = 0, first = 0; k <= minor; k++, across += side) {
+		if(k == minor) next = major + 1;
+		lineRun(dst, xMajor, across, pos, pos + step * (next - first - 1), color, op);
+		pos += step * (next - first);
+		first = next;
+		next += whole;
+		error -= remainder;
+		if(error < 0) {
+			next++;
+			error += 2 * minor;
+		}
+	}
+}
+
 /*************************************************************
 * drawLineB draws a line using Bresenham's line drawing algorithm.
 *
+* @param	dst is the surface to draw to.
 * @param	start is the first point that defines the line to draw.
 * @param	end is the second point that defines the line to draw.
 * @param	color is the color of the line to draw.
 *
 * @return	None.
 *
-* @note		None.
+* @note		Drawn by rasterLine.
 *************************************************************/
-void drawLineB(point start, point end, u32 color) {
-
-	//Bresenham's line algorithm implementation
-	int dx =  abs (end.x - start.x), sx = start.x < end.x ? 1 : -1;
-  	int dy = abs (end.y - start.y), sy = start.y < end.y ? 1 : -1;
-  	int err = dx - dy, e2; // error value e_xy
-
-  	for (;;){  // loop
-    	putPixel(start, color);
-    	if(start.x == end.x && start.y == end.y) break;
-		e2 = 2 * err;
-		if (e2 >= -dy) {
-			if(start.x == end.x) break;
-			err -= dy;
-			start.x += sx;
-		} // e_xy+e_x > 0
-		if (e2 <= dx) {
-			if(start.y == end.y) break;
-			err += dx;
-			start.y += sy;
-		} // e_xy+e_y < 0
-	}
+void drawLineB(surface *dst, point start, point end, u32 color) {
+	rasterLine(dst, start, end, color, ROP_COPY);
 }
 
 /*************************************************************
 * eraseLineB erases the line using Bresenham's line drawing algorithm.
 *
+* @param	dst is the surface to erase from.
 * @param	start is the first point that defines the line to erase.
 * @param	end is the second point that defines the line to erase.
 *
 * @return	None.
 *
+* @note		Drawn black by rasterLine, which clips and slices the
+* 			line like for drawLineB, so the pixels it drew are
+* 			cleared.
+*************************************************************/
+void eraseLineB(surface *dst, point start, point end) {
+	rasterLine(dst, start, end, black, ROP_COPY);
+}
+
+/*************************************************************
+* bounce reverses a moving speed if the next step leaves a range.
+*
+* @param	pos is the coordinate of the point.
+* @param	speed is the moving speed along it.
+* @param	low is the smallest coordinate of the range.
+* @param	high is the largest coordinate of the range.
+*
+* @return	None.
+*
 * @note		None.
 *************************************************************/
-void eraseLineB(point start, point end) {
-	//Bresenham's line algorithm implementation
-	int dx =  abs (end.x - start.x), sx = start.x < end.x ? 1 : -1;
-	int dy = abs (end.y - start.y), sy = start.y < end.y ? 1 : -1;
-	int err = dx - dy, e2; // error value e_xy
-	for (;;){  // loop
-	    	putPixel(start, black);
-	    	if(start.x == end.x && start.y == end.y) break;
-			e2 = 2 * err;
-			if (e2 >= -dy) {
-				if(start.x == end.x) break;
-				err -= dy;
-				start.x += sx;
-			} // e_xy+e_x > 0
-			if (e2 <= dx) {
-				if(start.y == end.y) break;
-				err += dx;
-				start.y += sy;
-			} // e_xy+e_y < 0
-		}
+static void bounce(int pos, int *speed, s32 low, s32 high) {
+	if(pos + *speed < low || pos + *speed > high) *speed = -*speed;
 }
 
 /*************************************************************
@@ -98,26 +251,35 @@ void eraseLineB(point start, point end) {
 *
 * @return	None.
 *
-* @note		None.
+* @note		The points bounce off the edges of the clip rectangle
+* 			of the screen. With indexed framebuffers the lines take
+* 			the colors of the cycled palette entries only, so every
+* 			line keeps cycling.
 *************************************************************/
 void drawLinesB(u32 t) {
-	drawLineB(startPoints[t], endPoints[t], rand()%16777215);
+	rect clip = getClip(&screenSurface);
+#if FB_INDEXED
+	u32 color = getPaletteEntry(LINES_CYCLE_FIRST + rand() % LINES_CYCLE_COUNT);
+#else
+	u32 color = rand()%16777215;
+#endif
+
+	drawLineB(&screenSurface, startPoints[t], endPoints[t], color);
 	usleep(50000);
 
-	//Check for screen borders and reverse direction
-	if(startPoints[t].x < abs(dx0) || startPoints[t].x >= (SCREEN_WIDTH-abs(dx0))) dx0 = -dx0;
-	if(startPoints[t].y < (abs(dy0)+1) || startPoints[t].y >= (SCREEN_HEIGHT-abs(dy0)) || (startPoints[t].y-abs(dy0)) <= 32) dy0 = -dy0;
-	if(endPoints[t].x < abs(dx1) || endPoints[t].x >= (SCREEN_WIDTH-abs(dx1))) dx1 = -dx1;
-	if(endPoints[t].y < abs(dy1) || endPoints[t].y >= (SCREEN_HEIGHT-abs(dy1)) || (endPoints[t].y-abs(dy1)) <= 32) dy1 = -dy1;
+	//Reverse direction before the next line would leave the clip rectangle
+	bounce(startPoints[t].x, &dx0, clip.x0, clip.x1);
+	bounce(startPoints[t].y, &dy0, clip.y0, clip.y1);
+	bounce(endPoints[t].x, &dx1, clip.x0, clip.x1);
+	bounce(endPoints[t].y, &dy1, clip.y0, clip.y1);
 
-	static int full = 0;
 	if(t == 255) full = 1;
 
 	u32 indexLast = (t == 255) ? 0 : (t + 1);
 
 	if(full) {
 		//Start deleting lines
-		eraseLineB(startPoints[indexLast],
+		eraseLineB(&screenSurface, startPoints[indexLast],
 					endPoints[indexLast]);
 		}
 		calculateLine(indexLast);
@@ -131,16 +293,18 @@ void drawLinesB(u32 t) {
 *
 * @return	None.
 *
-* @note		None.
+* @note		Called on every start of the lines sub-program, after
+* 			the display mode is set, the lines start over.
 *************************************************************/
 void initializeLines(void) {
 	dx0 = rand()%6 + 1;
 	dx1 = rand()%6 + 1;
 	dy0 = rand()%6 + 1;
 	dy1 = rand()%6 + 1;
+	full = 0;
 
-	startPoints[0] = (point) {rand()%640, rand()%448 + 32};
-	endPoints[0] = (point) {rand()%640, rand()%448 + 32};
+	startPoints[0] = (point) {rand()%SCREEN_WIDTH, rand()%(SCREEN_HEIGHT - LINES_TOP) + LINES_TOP};
+	endPoints[0] = (point) {rand()%SCREEN_WIDTH, rand()%(SCREEN_HEIGHT - LINES_TOP) + LINES_TOP};
 }
 
 /*************************************************************
@@ -5,7 +5,7 @@
 *
 * Author: Ahac Rafael Bela
 * Created on: 03.03.2025
-* Last modified: 14.04.2025
+* Last modified: 17.05.2025
 *************************************************************/
 //Protection macro
 #pragma once
@@ -17,13 +17,50 @@
 *************************************************************/
 #include "vga.h"
 
+/*************************************************************
+* Macro section
+*************************************************************/
+//Smallest screen the lines are drawn on, they need no more detail
+#define LINES_SCREEN_WIDTH	400
+#define LINES_SCREEN_HEIGHT	300
+//Palette entries the lines are drawn with and whose colors cycle with indexed framebuffers.
+//Black, dark gray and white of the background and the header are left out, so those keep
+//their colors: the color cube without its black and white corners with 8 bit indices, the
+//light colors 9 to 14 of the colors enum with 4, as 8 and 15 are the header's. With 1 bit
+//indices the lines are white and do not cycle.
+#if FB_BITS_PER_PIXEL == 8
+#define LINES_CYCLE_FIRST	17
+#define LINES_CYCLE_COUNT	214
+#elif FB_BITS_PER_PIXEL == 4
+#define LINES_CYCLE_FIRST	9
+#define LINES_CYCLE_COUNT	6
+#else
+#define LINES_CYCLE_FIRST	1
+#define LINES_CYCLE_COUNT	1
+#endif
+//Frames each color of the cycle is shown for
+#define LINES_CYCLE_PERIOD	4
+//First row the lines are drawn on, the header is above it
+#define LINES_TOP			32
+//Outcodes of a point outside a clip rectangle
+#define CLIP_LEFT			0x1
+#define CLIP_RIGHT			0x2
+#define CLIP_TOP			0x4
+#define CLIP_BOTTOM			0x8
+//Clip steps a line takes at most, more means it misses the clip rectangle
+#define CLIP_MAX_STEPS		4
+
 /*************************************************************
 * Function prototype section
 *************************************************************/
+//Cuts a line to the clip rectangle of a surface.
+ int clipLine(const surface *dst, point *start, point *end);
+//Draws a line as runs of pixels, combined with the pixels under it.
+ void rasterLine(surface *dst, point start, point end, u32 color, rasterOp op);
 //Draws a line using Bresenham's line drawing algorithm.
- void drawLineB(point start, point end, u32 color);
+ void drawLineB(surface *dst, point start, point end, u32 color);
  //Erases a line using Bresenham's line drawing algorithm.
- void eraseLineB(point start, point end);
+ void eraseLineB(surface *dst, point start, point end);
  //Draws 256 lines using Bresenham's line drawing algorithm.
  void drawLinesB(u32 t);
  //Initializes line's moving speed and sets a random starting point of the line.
@@ -4,7 +4,7 @@
 *
 * Author: Ahac Rafael Bela
 * Created on: 01.03.2025
-* Last modified: 10.04.2025
+* Last modified: 13.05.2025
 *************************************************************/
 
 /*************************************************************
@@ -13,6 +13,7 @@
 #include "libs.h"
 #include "vga.h"
 #include "lines.h"
+#include "bench.h"
 
 /*************************************************************
 * Global variable section
@@ -31,6 +32,12 @@ selectorWText selectorWText4;
 
 u32 discovered = 0;
 
+//Results of the last framebuffer mapping, compressed frame, pixel throughput and kernel benchmarks
+static benchResult benchResults[BENCH_MAPPINGS];
+static rleBenchResult rleResult;
+static spanBenchResult spanResult;
+static kernelBenchResult kernelResults[BENCH_KERNEL_PATHS];
+
 /*************************************************************
 * Main function section
 *************************************************************/
@@ -43,7 +50,9 @@ int main(void) {
 	if(initPlatform(ctrls) != XST_SUCCESS) return XST_FAILURE;
 
 	//Flushing cache, so the DMA transmits defined data
-	Xil_DCacheFlushRange((INTPTR) vgaArray, SCREEN_HEIGHT*SCREEN_WIDTH*sizeof(u32));
+	Xil_DCacheFlushRange((INTPTR) vgaBuffers, FB_COUNT*FB_MAX_SIZE);
+	//Map the framebuffers as configured, cached ones are flushed row by row before scanout
+	if(setFramebufferMapping(FB_MAPPING) != XST_SUCCESS) return XST_FAILURE;
 
 	xil_printf("\n\rHappy DMA-ing\n\r");
 
@@ -51,18 +60,7 @@ int main(void) {
 	enableInterrupts(ctrls);
 
 	//Setting selectorWText selector' and text' coordinates
-	selectorWText1 = (selectorWText){{SELECTOR_X, SELECTOR_Y(1)},
-					{SCREEN_WIDTH / 2 - strlen("Echo") * CHAR_WIDTH, (SELECTOR_Y(1) + SELECTOR_PADDING)},
-					"Echo"};
-	selectorWText2 = (selectorWText){{SELECTOR_X, SELECTOR_Y(2)},
-					{SCREEN_WIDTH / 2 - strlen("Lines") * CHAR_WIDTH, (SELECTOR_Y(2) + SELECTOR_PADDING)},
-					"Lines"};
-	selectorWText3 = (selectorWText){{SELECTOR_X, SELECTOR_Y(3)},
-					{SCREEN_WIDTH / 2 - strlen("Exit") * CHAR_WIDTH, (SELECTOR_Y(3) + SELECTOR_PADDING)},
-					"Exit"};
-	selectorWText4 = (selectorWText){{SELECTOR_X, SELECTOR_Y(4)},
-					{SCREEN_WIDTH / 2 - strlen("Extras") * CHAR_WIDTH, (SELECTOR_Y(4) + SELECTOR_PADDING)},
-					"Extras"};
+	initSelectors();
 
 	//First box is selected on startup
 	static int selected = 1;
@@ -76,9 +74,6 @@ int main(void) {
 	//Initializing the value to a null character
 	caughtChar = '\0';
 
-	//Sets the speed of moving lines to a random number (1 - 6)
-	initializeLines();
-
 	//Main while loop
 	while(1) {
 		//If an interrupt function has caught a character from keyboard input
@@ -102,6 +97,32 @@ int main(void) {
 				selected++;
 				discovered = 1;
 			}
+			//Framebuffer mapping benchmark, results are printed on the UART
+			else if(caughtChar == 'b') {
+				benchmarkMapping(benchResults);
+			}
+			//Compressed frame benchmark over the menu, results are printed on the UART
+			else if(caughtChar == 'r') {
+				benchmarkRle(&rleResult);
+			}
+			//Pixel throughput of the drawing primitives, results are printed on the UART
+			else if(caughtChar == 'p') {
+				benchmarkSpans(&spanResult);
+			}
+			//Scalar and vector fill, copy and expand kernels, results are printed on the UART
+			else if(caughtChar == 'k') {
+				benchmarkKernels(kernelResults);
+			}
+			//Next display mode the hardware can show, the menu is laid out again for it
+			else if(caughtChar == 'm') {
+				for(u32 i = 1; i < DISPLAY_MODES; i++) {
+					if(setDisplayMode((getDisplayMode() + i) % DISPLAY_MODES) == XST_SUCCESS) {
+						initSelectors();
+						drawStage();
+						break;
+					}
+				}
+			}
 
 			//Selecting of different menus, so they light up when going through them
 			selectorWText selectedMenu;
@@ -121,6 +142,7 @@ int main(void) {
 
 			//Highlights the selected navigation menu
 			selectMenu(selectedMenu);
+			present();
 
 			//Enter pressed, entering echo, lines or exit (+ extras)
 			if(caughtChar == 0xD) {
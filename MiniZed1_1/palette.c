@@ -0,0 +1,345 @@
+/**************************************************************
+ * File: palette.c
+ * Description: Palette of the indexed framebuffer formats, the
+ * expansion of indexed rows to XRGB8888 lines and palette
+ * animations run on VSync.
+ *
+ * Author: Ahac Rafael Bela
+ * Created on: 05.05.2025
+ * Last modified: 17.05.2025
+ *************************************************************/
+
+/*************************************************************
+* Include section
+*************************************************************/
+#include "palette.h"
+#include "vga.h"
+
+/*************************************************************
+* Global variable section
+*************************************************************/
+u32 palette[PALETTE_SIZE];
+u8 paletteMatch[PALETTE_KEYS];
+
+//Entries as set by setPalette, the animations are worked out from them
+static u32 paletteBase[PALETTE_SIZE];
+
+//Running animations, one bit per slot, and the frames each has run for
+static paletteAnimation animations[PALETTE_ANIMATIONS];
+static u32 animationFrames[PALETTE_ANIMATIONS];
+static volatile u32 animationsRunning = 0;
+
+//The colors enum in order, the first 16 entries of the default palette
+static const u32 defaultColors[16] = {
+	black, blue, green, cyan, red, purple, brown, gray,
+	d_gray, l_blue, l_green, l_cyan, l_red, l_purple, yellow, white
+};
+
+//Entries of two and of eight indices packed in a byte, so a byte is expanded with one lookup
+#if FB_BITS_PER_PIXEL == 4
+static u32 expandPairs[256][2];
+#elif FB_BITS_PER_PIXEL == 1
+static u32 expandOctets[256][8];
+#endif
+
+/*************************************************************
+* Function definition section
+*************************************************************/
+
+/*************************************************************
+* paletteUpdateTables rebuilds the byte expansion tables from
+* 			the palette.
+*
+* @param	None.
+*
+* @return	None.
+*
+* @note		Only 4 and 1 bit indices use tables.
+*************************************************************/
+static void paletteUpdateTables(void) {
+#if FB_BITS_PER_PIXEL == 4
+	for(u32 b = 0; b < 256; b++) {
+		expandPairs[b][0] = palette[b & 0xF];
+		expandPairs[b][1] = palette[b >> 4];
+	}
+#elif FB_BITS_PER_PIXEL == 1
+	for(u32 b = 0; b < 256; b++) {
+		for(u32 i = 0; i < 8; i++) expandOctets[b][i] = palette[(b >> i) & 1];
+	}
+#endif
+}
+
+/*************************************************************
+* paletteInit loads the default palette and matches the colors
+* 			to it.
+*
+* @param	None.
+*
+* @return	None.
+*
+* @note		The default palette starts with the colors enum. With
+* 			1 bit indices it is black and white. With 8 bit indices
+* 			a 6x6x6 color cube and a gray ramp follow.
+*************************************************************/
+void paletteInit(void) {
+	u32 colors[PALETTE_SIZE];
+
+	if(PALETTE_SIZE == 2) {
+		colors[0] = black;
+		colors[1] = white;
+	} else {
+		for(u32 i = 0; i < PALETTE_SIZE; i++) {
+			if(i < 16) colors[i] = defaultColors[i];
+			else if(i < 232) {
+				u32 c = i - 16;
+				colors[i] = (c % 6 * 0x33) | (c / 6 % 6 * 0x33) << 8 | (c / 36 * 0x33) << 16;
+			} else {
+				u32 level = (i - 232) * 15 / 23 * 0x11;
+				colors[i] = level | level << 8 | level << 16;
+			}
+		}
+	}
+	setPalette(0, PALETTE_SIZE, colors);
+	paletteMatchColors();
+}
+
+/*************************************************************
+* setPalette sets palette entries.
+*
+* @param	first is the first entry to set.
+* @param	count is the number of entries to set.
+* @param	colors is the new entries in XRGB8888.
+*
+* @return	None.
+*
+* @note		Pixels already drawn change with their entries, from
+* 			the next expanded line on. The colors drawn from now on
+* 			keep their indices until paletteMatchColors is called.
+* 			Entries of a running animation are animated from their
+* 			new colors on the next VSync.
+*************************************************************/
+void setPalette(u32 first, u32 count, const u32 *colors) {
+	for(u32 i = 0; i < count && first + i < PALETTE_SIZE; i++) {
+		palette[first + i] = colors[i];
+		paletteBase[first + i] = colors[i];
+	}
+	paletteUpdateTables();
+}
+
+/*************************************************************
+* getPaletteEntry returns the color of a palette entry as set
+* 			by setPalette.
+*
+* @param	index is the entry.
+*
+* @return	The color in XRGB8888, black for an entry past the
+* 			palette.
+*
+* @note		A running animation does not change it.
+*************************************************************/
+u32 getPaletteEntry(u32 index) {
+	return (index < PALETTE_SIZE) ? paletteBase[index] : black;
+}
+
+/*************************************************************
+* paletteMatchColors matches every color key to the closest
+* 			palette entry, so drawing a color selects it.
+*
+* @param	None.
+*
+* @return	None.
+*
+* @note		Ties go to the lower index, so the colors enum maps to
+* 			the first 16 entries of the default palette.
+*************************************************************/
+void paletteMatchColors(void) {
+	for(u32 key = 0; key < PALETTE_KEYS; key++) {
+		u32 best = 0, bestDistance = ~0U;
+
+		for(u32 i = 0; i < PALETTE_SIZE && bestDistance; i++) {
+			u32 entry = PALETTE_KEY(palette[i]);
+			s32 dr = (s32) (key & 0xF) - (s32) (entry & 0xF);
+			s32 dg = (s32) (key >> 4 & 0xF) - (s32) (entry >> 4 & 0xF);
+			s32 db = (s32) (key >> 8) - (s32) (entry >> 8);
+			u32 distance = dr * dr + dg * dg + db * db;
+
+			if(distance < bestDistance) {
+				best = i;
+				bestDistance = distance;
+			}
+		}
+		paletteMatch[key] = best;
+	}
+}
+
+/*************************************************************
+* paletteExpandLine expands a row of palette indices to an
+* 			XRGB8888 line.
+*
+* @param	src is the row of indices.
+* @param	dst is the line of SCREEN_WIDTH pixels to write.
+*
+* @return	None.
+*
+* @note		Called from HSyncIntrHandler through the prefetch
+* 			pipeline, one table lookup per byte of indices.
+*************************************************************/
+void paletteExpandLine(const u8 *src, u32 *dst) {
+#if FB_BITS_PER_PIXEL == 4
+	for(s32 i = 0; i < SCREEN_WIDTH / 2; i++, dst += 2) {
+		dst[0] = expandPairs[src[i]][0];
+		dst[1] = expandPairs[src[i]][1];
+	}
+#elif FB_BITS_PER_PIXEL == 1
+	for(s32 i = 0; i < SCREEN_WIDTH / 8; i++, dst += 8) memcpy(dst, expandOctets[src[i]], sizeof(expandOctets[0]));
+#else
+	for(s32 x = 0; x < SCREEN_WIDTH; x++) dst[x] = palette[src[x]];
+#endif
+}
+
+/*************************************************************
+* fadeColor mixes two colors.
+*
+* @param	from is the color at step 0.
+* @param	to is the color at the last step.
+* @param	step is the step to mix.
+* @param	steps is the number of steps.
+*
+* @return	The mixed color in XRGB8888.
+*
+* @note		None.
+*************************************************************/
+static u32 fadeColor(u32 from, u32 to, u32 step, u32 steps) {
+	u32 color = 0;
+
+	for(u32 shift = 0; shift < 24; shift += 8) {
+		s32 f = from >> shift & 0xFF, t = to >> shift & 0xFF;
+		color |= (u32) (f + (t - f) * (s32) step / (s32) steps) << shift;
+	}
+	return color;
+}
+
+/*************************************************************
+* applyAnimation sets the entries of an animation to their
+* 			colors at a frame.
+*
+* @param	animation is the animation.
+* @param	frames is the frames it has run for.
+*
+* @return
+* 			- 1 if an entry changed,
+* 			- 0 otherwise.
+*
+* @note		Worked out from the entries as set by setPalette, so
+* 			animations do not drift.
+*************************************************************/
+static int applyAnimation(const paletteAnimation *animation, u32 frames) {
+	u32 step = frames / animation->period;
+	int changed = 0;
+
+	for(u32 i = 0; i < animation->count; i++) {
+		u32 entry = animation->first + i, color;
+
+		if(animation->effect == PALETTE_CYCLE) {
+			color = paletteBase[animation->first + (i + step) % animation->count];
+		} else if(animation->effect == PALETTE_FADE) {
+			color = step ? animation->colors[i] : fadeColor(paletteBase[entry], animation->colors[i], frames, animation->period);
+		} else color = (step & 1) ? animation->colors[i] : paletteBase[entry];
+
+		if(palette[entry] != color) {
+			palette[entry] = color;
+			changed = 1;
+		}
+	}
+	return changed;
+}
+
+/*************************************************************
+* startPaletteAnimation starts animating a range of palette
+* 			entries.
+*
+* @param	animation is the animation, copied.
+*
+* @return
+* 			- id of the animation,
+* 			- -1 if the framebuffers are not indexed, the
+* 			  animation is not valid or all PALETTE_ANIMATIONS run.
+*
+* @note		The animation runs on VSync and only changes palette
+* 			entries, the pixels on screen change color without being
+* 			drawn again. Its colors must be kept until it is
+* 			stopped. VSync interrupt is disabled while the slot is
+* 			taken.
+*************************************************************/
+s32 startPaletteAnimation(const paletteAnimation *animation) {
+	s32 id = -1;
+
+	if(!FB_INDEXED || !animation->count || !animation->period || animation->first + animation->count > PALETTE_SIZE ||
+			(animation->effect != PALETTE_CYCLE && !animation->colors)) {
+		return -1;
+	}
+
+	XScuGic_Disable(ctrls->IntcInstancePtr, VSYNC_INTR_ID);
+	for(s32 i = 0; i < PALETTE_ANIMATIONS; i++) {
+		if(!(animationsRunning & 1 << i)) {
+			animations[i] = *animation;
+			animationFrames[i] = 0;
+			animationsRunning |= 1 << i;
+			id = i;
+			break;
+		}
+	}
+	XScuGic_Enable(ctrls->IntcInstancePtr, VSYNC_INTR_ID);
+
+	return id;
+}
+
+/*************************************************************
+* stopPaletteAnimation stops an animation and gives its entries
+* 			their own colors back.
+*
+* @param	id is the animation, -1 is ignored.
+*
+* @return	None.
+*
+* @note		The entries change from the next expanded line on.
+*************************************************************/
+void stopPaletteAnimation(s32 id) {
+	if(id < 0 || id >= PALETTE_ANIMATIONS) return;
+
+	XScuGic_Disable(ctrls->IntcInstancePtr, VSYNC_INTR_ID);
+	if(animationsRunning & 1 << id) {
+		animationsRunning &= ~(1 << id);
+		memcpy(&palette[animations[id].first], &paletteBase[animations[id].first], animations[id].count * sizeof(palette[0]));
+		paletteUpdateTables();
+	}
+	XScuGic_Enable(ctrls->IntcInstancePtr, VSYNC_INTR_ID);
+}
+
+/*************************************************************
+* updatePaletteAnimations advances the running animations by one
+* 			frame.
+*
+* @param	None.
+*
+* @return	None.
+*
+* @note		Called from VSyncIntrHandler, before the first line of
+* 			the frame is expanded, so a frame shows one palette.
+* 			Costs the animated entries and a rebuild of the byte
+* 			expansion tables, whatever the screen size.
+*************************************************************/
+void updatePaletteAnimations(void) {
+	int changed = 0;
+
+	for(u32 i = 0; i < PALETTE_ANIMATIONS; i++) {
+		if(!(animationsRunning & 1 << i)) continue;
+		changed |= applyAnimation(&animations[i], animationFrames[i]);
+		animationFrames[i]++;
+	}
+	if(changed) paletteUpdateTables();
+}
+
+/*************************************************************
+* End of file
+*************************************************************/
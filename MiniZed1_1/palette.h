@@ -0,0 +1,91 @@
+/**************************************************************
+ * File: palette.h
+ * Description: Palette of the indexed framebuffer formats, the
+ * expansion of indexed rows to XRGB8888 lines and palette
+ * animations run on VSync.
+ *
+ * Author: Ahac Rafael Bela
+ * Created on: 05.05.2025
+ * Last modified: 17.05.2025
+ *************************************************************/
+//Protection macro
+#pragma once
+#ifndef PALETTE_H
+#define PALETTE_H
+
+/*************************************************************
+* Include section
+*************************************************************/
+#include "libs.h"
+
+/*************************************************************
+* Macro section
+*************************************************************/
+//Number of palette entries an index can select
+#if FB_INDEXED
+#define PALETTE_SIZE		(1 << FB_BITS_PER_PIXEL)
+#else
+#define PALETTE_SIZE		256
+#endif
+//Mask of one index
+#define PALETTE_INDEX_MASK	(PALETTE_SIZE - 1)
+//Colors are matched to palette entries on the high 4 bits of each channel, the
+//resolution of the colors enum
+#define PALETTE_KEY(c)		(((c) >> 4 & 0xF) | ((c) >> 8 & 0xF0) | ((c) >> 12 & 0xF00))
+#define PALETTE_KEYS		4096
+//Palette animations that can run at the same time
+#define PALETTE_ANIMATIONS	8
+
+/*************************************************************
+* Enum section
+*************************************************************/
+typedef enum paletteEffect_t {
+	PALETTE_CYCLE,		//Entries rotate by one every period frames
+	PALETTE_FADE,		//Entries fade to colors over period frames and stay there
+	PALETTE_BLINK		//Entries switch between their own colors and colors every period frames
+} paletteEffect;
+
+/*************************************************************
+* Struct section
+*************************************************************/
+typedef struct paletteAnimation_t {
+	paletteEffect effect;
+	u32 first;			//First entry animated
+	u32 count;			//Entries animated
+	u32 period;			//Frames of one step of a cycle or blink, or of the whole fade
+	const u32 *colors;	//Count entries to fade or blink to in XRGB8888, unused by a cycle
+} paletteAnimation;
+
+/*************************************************************
+* Variable declaration section
+*************************************************************/
+//Entries in XRGB8888, red in the low byte
+extern u32 palette[PALETTE_SIZE];
+//Index of the palette entry closest to each color key
+extern u8 paletteMatch[PALETTE_KEYS];
+
+/*************************************************************
+* Function prototype section
+*************************************************************/
+//Loads the default palette and matches the colors to it.
+void paletteInit(void);
+//Sets palette entries, the next expanded line shows them.
+void setPalette(u32 first, u32 count, const u32 *colors);
+//Returns the color of a palette entry as set by setPalette.
+u32 getPaletteEntry(u32 index);
+//Matches every color key to the closest palette entry.
+void paletteMatchColors(void);
+//Expands a row of palette indices to an XRGB8888 line.
+void paletteExpandLine(const u8 *src, u32 *dst);
+//Starts animating a range of palette entries.
+s32 startPaletteAnimation(const paletteAnimation *animation);
+//Stops an animation and gives its entries their own colors back.
+void stopPaletteAnimation(s32 id);
+//Advances the running animations by one frame, called on VSync.
+void updatePaletteAnimations(void);
+
+#endif /* PALETTE_H */
+
+/*************************************************************
+* End of file
+*************************************************************/
@@ -0,0 +1,251 @@
+/**************************************************************
+ * File: prefetch.c
+ * Description: Scanout prefetch pipeline keeping a configurable
+ * number of lines flushed and queued ahead of the beam.
+ *
+ * Author: Ahac Rafael Bela
+ * Created on: 28.04.2025
+ * Last modified: 17.05.2025
+ *************************************************************/
+
+/*************************************************************
+* Include section
+*************************************************************/
+#include "prefetch.h"
+#include "framebuffer.h"
+#include "palette.h"
+#include "rle.h"
+
+/*************************************************************
+* Global variable section
+*************************************************************/
+volatile prefetchStats scanoutPrefetch = {PREFETCH_DEPTH, PREFETCH_MAX_DEPTH, 0, 0, 0};
+
+//Next line to flush and queue, FIRST_LINE from every VSync on
+static s32 nextLine = 0;
+
+u32 scanLines[SCAN_LINE_BUFFERS][DMA_BURST_BOUNDARY / 4] __attribute__((aligned(DMA_BURST_BOUNDARY)));
+const void *volatile scanLineSources[SCAN_LINE_BUFFERS];
+//Line buffer expanded last and the row it holds, a line showing the same row sends it again
+static u32 lastSlot = 0;
+static const void *lastSource = NULL;
+//Black line the blanking lines before the frame are sent from, flushed before its first use
+static u32 blankLine[DMA_BURST_BOUNDARY / 4] __attribute__((aligned(DMA_BURST_BOUNDARY)));
+static int blankLineFlushed = 0;
+
+/*************************************************************
+* Function definition section
+*************************************************************/
+
+/*************************************************************
+* setPrefetchDepth sets how many lines are kept ahead of the beam.
+*
+* @param	depth is the number of lines, 1 queues each line on its
+* 			own HSync.
+*
+* @return
+* 			- XST_SUCCESS if successful,
+* 			- XST_FAILURE if depth is out of range.
+*
+* @note		Takes effect on the next HSync.
+*************************************************************/
+int setPrefetchDepth(u32 depth) {
+	if(depth < 1 || depth > PREFETCH_MAX_DEPTH) return XST_FAILURE;
+
+	scanoutPrefetch.depth = depth;
+	resetPrefetchStats();
+
+	return XST_SUCCESS;
+}
+
+/*************************************************************
+* resetPrefetchStats clears the water marks and counters.
+*
+* @param	None.
+*
+* @return	None.
+*
+* @note		None.
+*************************************************************/
+void resetPrefetchStats(void) {
+	scanoutPrefetch.lowWater = PREFETCH_MAX_DEPTH;
+	scanoutPrefetch.highWater = 0;
+	scanoutPrefetch.underruns = 0;
+	scanoutPrefetch.catchUps = 0;
+}
+
+/*************************************************************
+* prefetchRestart restarts the pipeline at the first line of
+* 			a frame.
+*
+* @param	None.
+*
+* @return	None.
+*
+* @note		Called from VSyncIntrHandler.
+*************************************************************/
+void prefetchRestart(void) {
+	nextLine = FIRST_LINE;
+	lastSource = NULL;
+	if(!blankLineFlushed) {
+		Xil_DCacheFlushRange((INTPTR) blankLine, sizeof(blankLine));
+		blankLineFlushed = 1;
+	}
+}
+
+/*************************************************************
+* prefetchResume restarts the pipeline at the line of the beam,
+* 			so lines lost in a DMA reset are queued again.
+*
+* @param	beamLine is the line the beam is at.
+*
+* @return	None.
+*
+* @note		Called from the DMA error recovery.
+*************************************************************/
+void prefetchResume(s32 beamLine) {
+	nextLine = beamLine;
+	lastSource = NULL;
+}
+
+/*************************************************************
+* lineSource returns the row a line is sent from.
+*
+* @param	line is the line.
+*
+* @return	The first pixel of the row.
+*
+* @note		Visible lines show the row the row table of the scanout
+* 			buffer holds for them, blanking lines before the frame
+* 			are sent from the black line, never from the memory
+* 			before the framebuffer.
+*************************************************************/
+static inline pixel *lineSource(s32 line) {
+	return (line < 0) ? (pixel *) blankLine : scanoutLineRows[line];
+}
+
+/*************************************************************
+* repeatPixels widens a line of SCREEN_WIDTH pixels to SCAN_WIDTH,
+* 			each pixel repeated SCREEN_SCALE times.
+*
+* @param	src is the line to widen, in the format of the VGA
+* 			output, it may be dst itself.
+* @param	dst is the line buffer to write.
+*
+* @return	None.
+*
+* @note		Works from the last pixel back, so a line widened in
+* 			place reads each pixel before it is overwritten.
+*************************************************************/
+static void repeatPixels(const void *src, u32 *dst) {
+#if FB_FORMAT == FB_FORMAT_RGB565
+	const u16 *in = (const u16 *) src;
+	u16 *out = (u16 *) dst;
+#else
+	const u32 *in = (const u32 *) src;
+	u32 *out = dst;
+#endif
+
+	for(s32 x = SCREEN_WIDTH - 1; x >= 0; x--) {
+		u32 value = in[x];
+
+		for(s32 i = SCREEN_SCALE - 1; i >= 0; i--) out[x * SCREEN_SCALE + i] = value;
+	}
+}
+
+/*************************************************************
+* expandLine expands a row of the scanout buffer through the
+* 			palette, or decodes a row of the compressed frame,
+* 			into the next line buffer, with its pixels repeated
+* 			in a pixel-doubled mode.
+*
+* @param	line is the line to expand, blanking lines are sent
+* 			from the black line.
+* @param	rle is the compressed frame shown, NULL if none.
+*
+* @return	Pointer to the expanded line.
+*
+* @note		Only the line buffer needs cache maintenance, the CPU
+* 			reads the framebuffer and the runs through the cache.
+* 			Lines showing the row of the line before, like the
+* 			repeats of a row in a pixel-doubled mode or a shared
+* 			background row, send its line buffer again. Rows of
+* 			direct formats are only copied in pixel-doubled modes.
+*************************************************************/
+static u32 *expandLine(s32 line, const rleFrame *rle) {
+	const void *source;
+
+	if(line < 0) return blankLine;
+	source = rle ? (const void *) rle->rows[line / SCREEN_SCALE] : (const void *) lineSource(line);
+	if(source == lastSource) {
+		if(rle) rleDecodeStats.resent++;
+		return scanLines[lastSlot];
+	}
+
+	//Buffers are taken in turn, one is reused SCAN_LINE_BUFFERS expanded lines later
+	u32 slot = (lastSlot + 1) % SCAN_LINE_BUFFERS;
+	scanLineSources[slot] = source;
+	if(rle) rleDecodeLine(source, scanLines[slot]);
+#if FB_INDEXED
+	else paletteExpandLine(source, scanLines[slot]);
+#endif
+	if(SCREEN_SCALE > 1) repeatPixels((rle || FB_INDEXED) ? (const void *) scanLines[slot] : source, scanLines[slot]);
+	Xil_DCacheFlushRange((INTPTR) scanLines[slot], SCAN_LINE_BYTES);
+	lastSlot = slot;
+	lastSource = source;
+	return scanLines[slot];
+}
+
+/*************************************************************
+* prefetchLines flushes and queues lines until the configured
+* 			depth ahead of the beam is reached, so a late HSync
+* 			(e.g. behind a UART interrupt) still finds its line
+* 			already queued.
+*
+* @param	beamLine is the line the beam is at.
+*
+* @return	None.
+*
+* @note		Called from HSyncIntrHandler. Lines are sent from the
+* 			rows the row table holds for them. Only rows the CPU
+* 			wrote since they were last scanned out are flushed.
+* 			Rows of indexed framebuffers and of pixel-doubled
+* 			modes are expanded and rows of a compressed frame
+* 			decoded instead. In SG
+* 			mode the DMA owns the frame and VSyncIntrHandler
+* 			flushes it, only the water marks are kept.
+*************************************************************/
+void prefetchLines(s32 beamLine) {
+	s32 target = beamLine + (s32) scanoutPrefetch.depth - 1;
+	s32 ahead = nextLine - beamLine;
+	const rleFrame *rle = scanoutRle;
+	u32 queued = 0;
+
+	if(target > SCAN_HEIGHT - 1) target = SCAN_HEIGHT - 1;
+
+	//Water mark of lines already queued when the HSync arrived, the
+	//first line of a frame only primes the pipeline
+	if(beamLine != FIRST_LINE) {
+		if(ahead < scanoutPrefetch.lowWater) scanoutPrefetch.lowWater = ahead;
+		if(ahead <= 0 && nextLine <= target) scanoutPrefetch.underruns++;
+	}
+
+	for(; nextLine <= target; nextLine++, queued++) {
+		if(XAxiDma_HasSg(ctrls->AxiDma)) continue;
+		if(FB_INDEXED || rle || SCREEN_SCALE > 1) {
+			dmaReadReg(expandLine(nextLine, rle), SCAN_WIDTH, ctrls);
+			continue;
+		}
+		//Lines before the frame are blanking, nothing to flush, repeated rows are flushed once
+		if(nextLine >= 0) flushScanoutLine(nextLine);
+		dmaReadReg(lineSource(nextLine), SCAN_WIDTH, ctrls);
+	}
+	if(queued > 1 && beamLine != FIRST_LINE) scanoutPrefetch.catchUps++;
+
+	u32 waiting = dmaPendingLines();
+	if(waiting > scanoutPrefetch.highWater) scanoutPrefetch.highWater = waiting;
+}
+
+/*************************************************************
+* End of file
+*************************************************************/
@@ -0,0 +1,72 @@
+/**************************************************************
+ * File: prefetch.h
+ * Description: Scanout prefetch pipeline keeping a configurable
+ * number of lines flushed and queued ahead of the beam.
+ *
+ * Author: Ahac Rafael Bela
+ * Created on: 28.04.2025
+ * Last modified: 17.05.2025
+ *************************************************************/
+//Protection macro
+#pragma once
+#ifndef PREFETCH_H
+#define PREFETCH_H
+
+/*************************************************************
+* Include section
+*************************************************************/
+#include "libs.h"
+#include "display.h"
+
+/*************************************************************
+* Macro section
+*************************************************************/
+//Most lines that can be queued ahead of the beam
+#define PREFETCH_MAX_DEPTH	8
+//Lines queued ahead of the beam on startup, 1 is no prefetch
+#define PREFETCH_DEPTH		2
+//First line index of a frame, the vertical blanking lines of the display mode
+#define FIRST_LINE			(-(s32) DISPLAY_V_BLANK(currentMode))
+//Expanded lines of an indexed framebuffer, a pixel-doubled mode or a compressed frame kept for the DMA,
+//a power of 2 above PREFETCH_MAX_DEPTH, so a line is not overwritten before it is sent
+#define SCAN_LINE_BUFFERS	16
+
+/*************************************************************
+* Struct section
+*************************************************************/
+typedef struct prefetchStats_t {
+	u32 depth;			//Configured number of lines ahead of the beam
+	s32 lowWater;		//Fewest lines queued ahead when HSync arrived
+	u32 highWater;		//Most lines waiting for the DMA at once
+	u32 underruns;		//HSyncs that found the line of the beam not queued
+	u32 catchUps;		//HSyncs that had to queue more than one line
+} prefetchStats;
+
+/*************************************************************
+* Variable declaration section
+*************************************************************/
+extern volatile prefetchStats scanoutPrefetch;
+//Expanded lines, each inside one DMA_BURST_BOUNDARY
+extern u32 scanLines[SCAN_LINE_BUFFERS][DMA_BURST_BOUNDARY / 4];
+//Framebuffer row or row of runs each expanded line was expanded from, NULL until it is first used
+extern const void *volatile scanLineSources[SCAN_LINE_BUFFERS];
+
+/*************************************************************
+* Function prototype section
+*************************************************************/
+//Sets how many lines are kept ahead of the beam.
+int setPrefetchDepth(u32 depth);
+//Clears the water marks and counters.
+void resetPrefetchStats(void);
+//Restarts the pipeline at the first line of a frame, called on VSync.
+void prefetchRestart(void);
+//Restarts the pipeline at the line of the beam, used after a DMA reset.
+void prefetchResume(s32 beamLine);
+//Tops the pipeline up to the configured depth ahead of the beam, called on HSync.
+void prefetchLines(s32 beamLine);
+
+#endif /* PREFETCH_H */
+
+/*************************************************************
+* End of file
+*************************************************************/
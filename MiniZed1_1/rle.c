@@ -0,0 +1,264 @@
+/**************************************************************
+ * File: rle.c
+ * Description: Run-length compressed frames, decoded line by
+ * line ahead of the beam instead of scanning out a framebuffer.
+ *
+ * Author: Ahac Rafael Bela
+ * Created on: 10.05.2025
+ * Last modified: 17.05.2025
+ *************************************************************/
+
+/*************************************************************
+* Include section
+*************************************************************/
+#include "rle.h"
+#include "vga.h"
+
+/*************************************************************
+* Global variable section
+*************************************************************/
+const rleFrame *volatile scanoutRle = NULL;
+volatile rleStats rleDecodeStats = {0, 0, 0, 0};
+
+//Compressed frame shown from the next VSync on
+static const rleFrame *volatile pendingRle = NULL;
+
+/*************************************************************
+* Function definition section
+*************************************************************/
+
+/*************************************************************
+* readPixel reads one pixel of a row.
+*
+* @param	row is the row to read from.
+* @param	x is the column of the pixel.
+*
+* @return	The pixel, the palette index in the indexed formats.
+*
+* @note		None.
+*************************************************************/
+static inline u32 readPixel(const pixel *row, u32 x) {
+#if FB_INDEXED
+	return ((const u8 *) row)[x / PIXELS_PER_BYTE] >> (x % PIXELS_PER_BYTE * FB_BITS_PER_PIXEL) & PALETTE_INDEX_MASK;
+#else
+	return row[x];
+#endif
+}
+
+/*************************************************************
+* sameRuns compares the runs of two rows.
+*
+* @param	a is the first run of one row.
+* @param	b is the first run of the other row.
+* @param	width is the pixels of a row.
+*
+* @return
+* 			- 1 if the rows have the same runs,
+* 			- 0 otherwise.
+*
+* @note		None.
+*************************************************************/
+static int sameRuns(const rleRun *a, const rleRun *b, u32 width) {
+	for(u32 x = 0; x < width; x += RLE_LENGTH(*a), a++, b++) {
+		if(*a != *b) return 0;
+	}
+	return 1;
+}
+
+/*************************************************************
+* hashRuns hashes the runs of a row (FNV-1a over the words).
+*
+* @param	run is the first run of the row.
+* @param	count is the number of runs.
+*
+* @return	The hash.
+*
+* @note		None.
+*************************************************************/
+static u32 hashRuns(const rleRun *run, u32 count) {
+	u32 hash = 2166136261U;
+
+	for(u32 i = 0; i < count; i++) hash = (hash ^ run[i]) * 16777619U;
+	return hash;
+}
+
+/*************************************************************
+* rleEncode compresses a surface into runs of equal pixels, one
+* 			list of runs per row.
+*
+* @param	frame is the compressed frame to build.
+* @param	src is the surface to compress.
+* @param	runs is the storage of the runs.
+* @param	maxRuns is the number of runs the storage holds.
+*
+* @return
+* 			- XST_SUCCESS if successful,
+* 			- XST_FAILURE if the surface has more rows than
+* 			  SCREEN_MAX_HEIGHT or more runs than maxRuns.
+*
+* @note		Rows with the same runs as an earlier row share its
+* 			runs, so a mostly uniform screen takes a few KB. Earlier
+* 			distinct rows are found through a table keyed by the
+* 			hash of their runs, so a row is compared with the rows
+* 			of its hash only. The runs are only read by the CPU and
+* 			need no flush.
+*************************************************************/
+int rleEncode(rleFrame *frame, const surface *src, rleRun *runs, u32 maxRuns) {
+	//Distinct rows plus one by hash slot, 0 for an empty slot, and the hash of each distinct row
+	static u16 slots[RLE_HASH_SLOTS];
+	static u32 rowHash[SCREEN_MAX_HEIGHT];
+	u32 used = 0;
+
+	if(src->height > SCREEN_MAX_HEIGHT) return XST_FAILURE;
+
+	memset(slots, 0, sizeof(slots));
+	frame->width = src->width;
+	frame->height = src->height;
+	for(u32 y = 0; y < src->height; y++) {
+		const pixel *row = SURFACE_ROW(src, y);
+		rleRun *first = &runs[used];
+		u32 count = 0;
+
+		for(u32 x = 0, length; x < src->width; x += length) {
+			u32 value = readPixel(row, x);
+
+			for(length = 1; x + length < src->width && length < RLE_MAX_LENGTH && readPixel(row, x + length) == value; length++);
+			if(used + count == maxRuns) return XST_FAILURE;
+			first[count++] = RLE_RUN(value, length);
+		}
+
+		u32 hash = hashRuns(first, count);
+		u32 slot = hash % RLE_HASH_SLOTS;
+
+		frame->rows[y] = first;
+		for(; slots[slot]; slot = (slot + 1) % RLE_HASH_SLOTS) {
+			u32 i = slots[slot] - 1;
+
+			if(rowHash[i] == hash && sameRuns(frame->rows[i], first, src->width)) {
+				frame->rows[y] = frame->rows[i];
+				break;
+			}
+		}
+		if(frame->rows[y] == first) {
+			slots[slot] = y + 1;
+			rowHash[y] = hash;
+			used += count;
+		}
+	}
+	frame->runCount = used;
+
+	return XST_SUCCESS;
+}
+
+/*************************************************************
+* rleFrameBytes returns the bytes a compressed frame takes.
+*
+* @param	frame is the compressed frame.
+*
+* @return	Bytes of the row pointers and of the runs used.
+*
+* @note		None.
+*************************************************************/
+u32 rleFrameBytes(const rleFrame *frame) {
+	return frame->height * sizeof(frame->rows[0]) + frame->runCount * sizeof(rleRun);
+}
+
+/*************************************************************
+* showRleFrame shows a compressed frame instead of the
+* 			framebuffers from the next VSync on.
+*
+* @param	frame is the compressed frame, NULL shows the
+* 			framebuffers again.
+*
+* @return
+* 			- XST_SUCCESS if successful,
+* 			- XST_FAILURE if the frame does not have the size of the
+* 			  display mode or the DMA is in SG mode.
+*
+* @note		The lines are decoded ahead of the beam like the lines
+* 			of indexed framebuffers, which the SG ring can not do.
+* 			The frame must be kept until the framebuffers are
+* 			shown again. Present keeps working on the framebuffers
+* 			meanwhile.
+*************************************************************/
+int showRleFrame(const rleFrame *frame) {
+	if(frame && (XAxiDma_HasSg(ctrls->AxiDma) || frame->width != (u32) SCREEN_WIDTH || frame->height != (u32) SCREEN_HEIGHT)) {
+		return XST_FAILURE;
+	}
+	pendingRle = frame;
+
+	return XST_SUCCESS;
+}
+
+/*************************************************************
+* flipRleFrame switches the scanout to the compressed frame asked
+* 			for by showRleFrame.
+*
+* @param	None.
+*
+* @return	None.
+*
+* @note		Called from VSyncIntrHandler, before the first line of
+* 			the next frame is queued.
+*************************************************************/
+void flipRleFrame(void) {
+	scanoutRle = pendingRle;
+}
+
+/*************************************************************
+* rleDecodeLine decodes a row of runs into a line for the VGA
+* 			output.
+*
+* @param	run is the first run of the row.
+* @param	dst is the line of SCREEN_WIDTH pixels to write.
+*
+* @return	None.
+*
+* @note		Called from HSyncIntrHandler through the prefetch
+* 			pipeline, its run time is kept in rleDecodeStats.
+* 			Palette indices are expanded with the palette of the
+* 			moment.
+*************************************************************/
+void rleDecodeLine(const rleRun *run, u32 *dst) {
+#if FB_FORMAT == FB_FORMAT_RGB565
+	u16 *line = (u16 *) dst;
+#else
+	u32 *line = dst;
+#endif
+	XTime start, end;
+
+	XTime_GetTime(&start);
+	for(u32 x = 0; x < (u32) SCREEN_WIDTH; run++) {
+#if FB_INDEXED
+		u32 value = palette[RLE_VALUE(*run)];
+#else
+		u32 value = RLE_VALUE(*run);
+#endif
+		for(u32 last = x + RLE_LENGTH(*run); x < last; x++) line[x] = value;
+	}
+	XTime_GetTime(&end);
+
+	rleDecodeStats.decoded++;
+	rleDecodeStats.totalTime += end - start;
+	if(end - start > rleDecodeStats.maxTime) rleDecodeStats.maxTime = end - start;
+}
+
+/*************************************************************
+* resetRleStats clears the decode timings.
+*
+* @param	None.
+*
+* @return	None.
+*
+* @note		None.
+*************************************************************/
+void resetRleStats(void) {
+	rleDecodeStats.decoded = 0;
+	rleDecodeStats.resent = 0;
+	rleDecodeStats.totalTime = 0;
+	rleDecodeStats.maxTime = 0;
+}
+
+/*************************************************************
+* End of file
+*************************************************************/
@@ -0,0 +1,85 @@
+/**************************************************************
+ * File: rle.h
+ * Description: Run-length compressed frames, decoded line by
+ * line ahead of the beam instead of scanning out a framebuffer.
+ *
+ * Author: Ahac Rafael Bela
+ * Created on: 10.05.2025
+ * Last modified: 17.05.2025
+ *************************************************************/
+//Protection macro
+#pragma once
+#ifndef RLE_H
+#define RLE_H
+
+/*************************************************************
+* Include section
+*************************************************************/
+#include "libs.h"
+
+/*************************************************************
+* Macro section
+*************************************************************/
+//A run is one word, the framebuffer pixel (a palette index in the indexed formats) in the
+//low RLE_VALUE_BITS and the pixels it is repeated for above them. Longer runs are split,
+//the unused top byte of XRGB8888 pixels is dropped.
+#define RLE_VALUE_BITS		((FB_FORMAT == FB_FORMAT_XRGB8888) ? 24 : 16)
+#define RLE_VALUE_MASK		((1U << RLE_VALUE_BITS) - 1)
+#define RLE_MAX_LENGTH		((1U << (32 - RLE_VALUE_BITS)) - 1)
+#define RLE_RUN(value, length)	((rleRun) ((u32) (length) << RLE_VALUE_BITS | ((value) & RLE_VALUE_MASK)))
+#define RLE_VALUE(run)		((run) & RLE_VALUE_MASK)
+#define RLE_LENGTH(run)		((run) >> RLE_VALUE_BITS)
+//Slots of the table rows are matched through, a power of 2 above SCREEN_MAX_HEIGHT
+#define RLE_HASH_SLOTS		2048
+
+/*************************************************************
+* Type section
+*************************************************************/
+//One run, built with RLE_RUN
+typedef u32 rleRun;
+
+/*************************************************************
+* Struct section
+*************************************************************/
+typedef struct rleFrame_t {
+	u32 width;			//Pixels of each row
+	u32 height;			//Rows
+	u32 runCount;		//Runs used of the run storage
+	const rleRun *rows[SCREEN_MAX_HEIGHT];	//First run of each row, rows with the same runs share them
+} rleFrame;
+
+typedef struct rleStats_t {
+	u32 decoded;		//Lines decoded
+	u32 resent;			//Lines that sent the line decoded before them again
+	XTime totalTime;	//Time spent decoding in global timer ticks
+	XTime maxTime;		//Longest decode of one line
+} rleStats;
+
+/*************************************************************
+* Variable declaration section
+*************************************************************/
+//Compressed frame shown instead of the framebuffers, NULL if none
+extern const rleFrame *volatile scanoutRle;
+extern volatile rleStats rleDecodeStats;
+
+/*************************************************************
+* Function prototype section
+*************************************************************/
+//Compresses a surface into runs of equal pixels.
+int rleEncode(rleFrame *frame, const surface *src, rleRun *runs, u32 maxRuns);
+//Returns the bytes a compressed frame takes.
+u32 rleFrameBytes(const rleFrame *frame);
+//Shows a compressed frame instead of the framebuffers from the next VSync on.
+int showRleFrame(const rleFrame *frame);
+//Switches the scanout to the compressed frame asked for, called on VSync.
+void flipRleFrame(void);
+//Decodes a row of runs into a line for the VGA output.
+void rleDecodeLine(const rleRun *run, u32 *dst);
+//Clears the decode timings.
+void resetRleStats(void);
+
+#endif /* RLE_H */
+
+/*************************************************************
+* End of file
+*************************************************************/
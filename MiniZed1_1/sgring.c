@@ -0,0 +1,146 @@
+/**************************************************************
+ * File: sgring.c
+ * Description: Scatter-gather descriptor ring for full-frame
+ * scanout with the AXI DMA MM2S channel.
+ *
+ * Author: Ahac Rafael Bela
+ * Created on: 22.04.2025
+ * Last modified: 17.05.2025
+ *************************************************************/
+
+/*************************************************************
+* Include section
+*************************************************************/
+#include "sgring.h"
+
+/*************************************************************
+* Global variable section
+*************************************************************/
+sgRing scanoutRing;
+
+static sgDescriptor sgDescriptors[SG_MAX_BDS];
+
+/*************************************************************
+* Function definition section
+*************************************************************/
+
+/*************************************************************
+* sgRingInit sets up a ring of SG_RING_FRAMES frame segments of
+* 			one descriptor per visible line and starts the MM2S
+* 			channel. Each segment describes one whole frame, the
+* 			last descriptor of the last segment links back to the
+* 			first.
+*
+* @param	ring is the ring to initialize.
+* @param	regBase is the base address of the MM2S channel registers.
+* @param	rowsPerBd is the most lines one descriptor transfers,
+* 			rows padded to FB_PITCH always get one descriptor each.
+*
+* @return
+* 			- XST_SUCCESS if successful,
+* 			- XST_FAILURE if rowsPerBd does not fit in a descriptor.
+*
+* @note		The descriptors of a segment are written when its frame
+* 			is submitted, the engine is left running and idle until
+* 			the first call to sgRingSubmitFrame.
+*************************************************************/
+int sgRingInit(sgRing *ring, UINTPTR regBase, u32 rowsPerBd) {
+	u32 rowBytes = FB_LINE_BYTES;
+
+	if(rowsPerBd == 0 || rowsPerBd * rowBytes > SG_MAX_BD_LENGTH) return XST_FAILURE;
+	//Padded rows are not contiguous, every line needs its own descriptor
+	if(FB_PITCH != rowBytes) rowsPerBd = 1;
+
+	ring->bds = sgDescriptors;
+	ring->regBase = regBase;
+	ring->bdsPerSegment = SCAN_HEIGHT;
+	ring->bdsInFrame = 0;
+	ring->rowsPerBd = rowsPerBd;
+	//First submitted frame goes to segment 0
+	ring->segment = SG_RING_FRAMES - 1;
+	ring->framesSubmitted = 0;
+
+	memset(ring->bds, 0, ring->bdsPerSegment * SG_RING_FRAMES * sizeof(sgDescriptor));
+	//The DMA fetches descriptors from DDR
+	Xil_DCacheFlushRange((INTPTR) ring->bds, ring->bdsPerSegment * SG_RING_FRAMES * sizeof(sgDescriptor));
+
+	//Current descriptor can only be set while the channel is halted
+	Xil_Out32(regBase + XAXIDMA_CDESC_OFFSET, (u32) (UINTPTR) ring->bds);
+	Xil_Out32(regBase + XAXIDMA_CR_OFFSET, Xil_In32(regBase + XAXIDMA_CR_OFFSET) | XAXIDMA_CR_RUNSTOP_MASK);
+
+	return XST_SUCCESS;
+}
+
+/*************************************************************
+* sgRingRestart points the channel at the first descriptor of
+* 			the next frame segment and starts it again.
+*
+* @param	ring is the ring to restart.
+*
+* @return	None.
+*
+* @note		Must be called with the channel halted, e.g. after a
+* 			reset. The frame in flight is lost, the next call to
+* 			sgRingSubmitFrame sends a whole frame again.
+*************************************************************/
+void sgRingRestart(sgRing *ring) {
+	u32 next = (ring->segment + 1) % SG_RING_FRAMES;
+
+	Xil_Out32(ring->regBase + XAXIDMA_CDESC_OFFSET, (u32) (UINTPTR) &ring->bds[next * ring->bdsPerSegment]);
+	Xil_Out32(ring->regBase + XAXIDMA_CR_OFFSET, Xil_In32(ring->regBase + XAXIDMA_CR_OFFSET) | XAXIDMA_CR_RUNSTOP_MASK);
+}
+
+/*************************************************************
+* sgRingSubmitFrame describes a frame in the next segment and
+* 			hands it to the DMA. Moving the tail pointer to the
+* 			end of the frame makes the engine fetch every
+* 			descriptor of it on its own.
+*
+* @param	ring is the ring to submit from.
+* @param	lines is the row table of the frame, the row each
+* 			visible line is sent from.
+*
+* @return	None.
+*
+* @note		Lines showing consecutive rows of contiguous memory
+* 			share a descriptor, up to rowsPerBd of them. Repeated
+* 			and shared rows get a descriptor for each line. The
+* 			segment finished SG_RING_FRAMES - 1 frames ago, so
+* 			its descriptors are free to be written again, with the
+* 			status words cleared, as the DMA refuses descriptors
+* 			still marked complete.
+*************************************************************/
+void sgRingSubmitFrame(sgRing *ring, pixel *const *lines) {
+	ring->segment = (ring->segment + 1) % SG_RING_FRAMES;
+	sgDescriptor *first = &ring->bds[ring->segment * ring->bdsPerSegment];
+	sgDescriptor *next = &ring->bds[((ring->segment + 1) % SG_RING_FRAMES) * ring->bdsPerSegment];
+	u32 height = SCAN_HEIGHT;
+	u32 count = 0;
+
+	for(u32 line = 0; line < height; count++) {
+		u32 rows = 1;
+
+		//Consecutive rows of contiguous memory are sent as one block
+		while(rows < ring->rowsPerBd && line + rows < height && lines[line + rows] == lines[line] + rows * FB_STRIDE) rows++;
+
+		first[count].nextDesc = (u32) (UINTPTR) &first[count + 1];
+		first[count].bufferAddr = (u32) (UINTPTR) lines[line];
+		first[count].control = rows * FB_LINE_BYTES;
+		first[count].status = 0;
+		line += rows;
+	}
+	//One frame is sent as one packet, the engine continues with the next segment
+	first[0].control |= XAXIDMA_BD_CTRL_TXSOF_MASK;
+	first[count - 1].control |= XAXIDMA_BD_CTRL_TXEOF_MASK;
+	first[count - 1].nextDesc = (u32) (UINTPTR) next;
+	ring->bdsInFrame = count;
+	Xil_DCacheFlushRange((INTPTR) first, count * sizeof(sgDescriptor));
+
+	//Writing the tail pointer starts the transfer of the whole frame
+	Xil_Out32(ring->regBase + XAXIDMA_TDESC_OFFSET, (u32) (UINTPTR) &first[count - 1]);
+	ring->framesSubmitted++;
+}
+
+/*************************************************************
+* End of file
+*************************************************************/
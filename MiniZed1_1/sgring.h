@@ -0,0 +1,77 @@
+/**************************************************************
+ * File: sgring.h
+ * Description: Scatter-gather descriptor ring for full-frame
+ * scanout with the AXI DMA MM2S channel.
+ *
+ * Author: Ahac Rafael Bela
+ * Created on: 22.04.2025
+ * Last modified: 09.05.2025
+ *************************************************************/
+//Protection macro
+#pragma once
+#ifndef SGRING_H
+#define SGRING_H
+
+/*************************************************************
+* Include section
+*************************************************************/
+#include "libs.h"
+
+/*************************************************************
+* Macro section
+*************************************************************/
+//Number of frame segments in the ring, the tail pointer alternates between them
+#define SG_RING_FRAMES		2
+//Maximum number of descriptors, one line of the largest display mode per descriptor in every segment
+#define SG_MAX_BDS			(SCREEN_MAX_HEIGHT * SG_RING_FRAMES)
+//Default number of lines of consecutive rows described by one descriptor
+#define SG_ROWS_PER_BD		4
+//Largest transfer of one descriptor
+#define SG_MAX_BD_LENGTH	DMA_MAX_LENGTH
+
+/*************************************************************
+* Struct section
+*************************************************************/
+//Buffer descriptor as laid out in memory by the AXI DMA (64-byte aligned)
+typedef struct sgDescriptor_t {
+	u32 nextDesc;			//Address of the next descriptor
+	u32 nextDescMsb;		//Upper 32 bits of the next descriptor address
+	u32 bufferAddr;			//Address of the data to transfer
+	u32 bufferAddrMsb;		//Upper 32 bits of the data address
+	u32 reserved[2];		//Unused
+	u32 control;			//Transfer length and SOF/EOF flags
+	u32 status;				//Completion and error status written by the DMA
+	u32 app[5];				//User application fields
+	u32 padding[3];			//Pads the descriptor to 64 bytes
+} __attribute__((aligned(XAXIDMA_BD_MINIMUM_ALIGNMENT))) sgDescriptor;
+
+typedef struct sgRing_t {
+	sgDescriptor *bds;		//Descriptor storage
+	UINTPTR regBase;		//Base address of the MM2S channel registers
+	u32 bdsPerSegment;		//Descriptors kept for each frame segment, one per visible line
+	u32 bdsInFrame;			//Descriptors the last submitted frame used
+	u32 rowsPerBd;			//Most lines of consecutive rows per descriptor
+	u32 segment;			//Index of the last submitted frame segment
+	u32 framesSubmitted;	//Number of frames handed to the DMA
+} sgRing;
+
+/*************************************************************
+* Variable declaration section
+*************************************************************/
+extern sgRing scanoutRing;
+
+/*************************************************************
+* Function prototype section
+*************************************************************/
+//Sets up the descriptor ring for the display mode and starts the MM2S channel.
+int sgRingInit(sgRing *ring, UINTPTR regBase, u32 rowsPerBd);
+//Points the channel at the next frame segment after a reset.
+void sgRingRestart(sgRing *ring);
+//Describes a frame by its row table and hands it to the DMA with a single tail pointer write.
+void sgRingSubmitFrame(sgRing *ring, pixel *const *lines);
+
+#endif /* SGRING_H */
+
+/*************************************************************
+* End of file
+*************************************************************/
@@ -0,0 +1,25 @@
+/**************************************************************
+ * File: sleep.h
+ * Description: Host simulation stand-in for the BSP sleep
+ * functions, which return immediately.
+ *
+ * Author: Ahac Rafael Bela
+ * Created on: 30.04.2025
+ * Last modified: 30.04.2025
+ *************************************************************/
+//Protection macro
+#pragma once
+#ifndef SLEEP_H
+#define SLEEP_H
+
+/*************************************************************
+* Function prototype section
+*************************************************************/
+int usleep(unsigned long useconds);
+unsigned sleep(unsigned int seconds);
+
+#endif /* SLEEP_H */
+
+/*************************************************************
+* End of file
+*************************************************************/
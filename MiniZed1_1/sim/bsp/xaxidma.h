@@ -0,0 +1,67 @@
+/**************************************************************
+ * File: xaxidma.h
+ * Description: Host simulation stand-in for the AXI DMA driver.
+ *
+ * Author: Ahac Rafael Bela
+ * Created on: 30.04.2025
+ * Last modified: 30.04.2025
+ *************************************************************/
+//Protection macro
+#pragma once
+#ifndef XAXIDMA_H
+#define XAXIDMA_H
+
+/*************************************************************
+* Include section
+*************************************************************/
+#include "xaxidma_hw.h"
+
+/*************************************************************
+* Macro section
+*************************************************************/
+#define XAXIDMA_DMA_TO_DEVICE	0x00
+#define XAXIDMA_DEVICE_TO_DMA	0x01
+
+#define XAxiDma_HasSg(InstancePtr)	((InstancePtr)->HasSg)
+
+/*************************************************************
+* Struct section
+*************************************************************/
+typedef struct {
+	u32 DeviceId;
+	UINTPTR BaseAddr;
+	int HasStsCntrlStrm;
+	int HasMm2s;
+	int HasMm2sDRE;
+	int Mm2SDataWidth;
+	int HasS2Mm;
+	int HasS2MmDRE;
+	int S2MmDataWidth;
+	int HasSg;
+} XAxiDma_Config;
+
+typedef struct {
+	UINTPTR RegBase;
+	int HasMm2s;
+	int HasS2Mm;
+	int HasSg;
+	u32 Initialized;
+} XAxiDma;
+
+/*************************************************************
+* Function prototype section
+*************************************************************/
+XAxiDma_Config *XAxiDma_LookupConfig(u32 DeviceId);
+int XAxiDma_CfgInitialize(XAxiDma *InstancePtr, XAxiDma_Config *Config);
+void XAxiDma_Reset(XAxiDma *InstancePtr);
+int XAxiDma_ResetIsDone(XAxiDma *InstancePtr);
+void XAxiDma_IntrEnable(XAxiDma *InstancePtr, u32 Mask, int Direction);
+void XAxiDma_IntrDisable(XAxiDma *InstancePtr, u32 Mask, int Direction);
+u32 XAxiDma_IntrGetIrq(XAxiDma *InstancePtr, int Direction);
+void XAxiDma_IntrAckIrq(XAxiDma *InstancePtr, u32 Mask, int Direction);
+
+#endif /* XAXIDMA_H */
+
+/*************************************************************
+* End of file
+*************************************************************/
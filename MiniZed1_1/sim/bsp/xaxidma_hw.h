@@ -0,0 +1,78 @@
+/**************************************************************
+ * File: xaxidma_hw.h
+ * Description: Host simulation stand-in for the AXI DMA
+ * register map.
+ *
+ * Author: Ahac Rafael Bela
+ * Created on: 30.04.2025
+ * Last modified: 30.04.2025
+ *************************************************************/
+//Protection macro
+#pragma once
+#ifndef XAXIDMA_HW_H
+#define XAXIDMA_HW_H
+
+/*************************************************************
+* Include section
+*************************************************************/
+#include "xil_io.h"
+
+/*************************************************************
+* Macro section
+*************************************************************/
+//Channel offsets
+#define XAXIDMA_TX_OFFSET				0x00000000
+#define XAXIDMA_RX_OFFSET				0x00000030
+
+//Channel registers
+#define XAXIDMA_CR_OFFSET				0x00000000
+#define XAXIDMA_SR_OFFSET				0x00000004
+#define XAXIDMA_CDESC_OFFSET			0x00000008
+#define XAXIDMA_CDESC_MSB_OFFSET		0x0000000C
+#define XAXIDMA_TDESC_OFFSET			0x00000010
+#define XAXIDMA_TDESC_MSB_OFFSET		0x00000014
+#define XAXIDMA_SRCADDR_OFFSET			0x00000018
+#define XAXIDMA_SRCADDR_MSB_OFFSET		0x0000001C
+#define XAXIDMA_DESTADDR_OFFSET			0x00000018
+#define XAXIDMA_DESTADDR_MSB_OFFSET		0x0000001C
+#define XAXIDMA_BUFFLEN_OFFSET			0x00000028
+
+//Control register
+#define XAXIDMA_CR_RUNSTOP_MASK			0x00000001
+#define XAXIDMA_CR_RESET_MASK			0x00000004
+#define XAXIDMA_CR_KEYHOLE_MASK			0x00000008
+#define XAXIDMA_CR_CYCLIC_MASK			0x00000010
+
+//Status register
+#define XAXIDMA_HALTED_MASK				0x00000001
+#define XAXIDMA_IDLE_MASK				0x00000002
+#define XAXIDMA_ERR_INTERNAL_MASK		0x00000010
+#define XAXIDMA_ERR_SLAVE_MASK			0x00000020
+#define XAXIDMA_ERR_DECODE_MASK			0x00000040
+#define XAXIDMA_ERR_SG_INT_MASK			0x00000100
+#define XAXIDMA_ERR_SG_SLV_MASK			0x00000200
+#define XAXIDMA_ERR_SG_DEC_MASK			0x00000400
+#define XAXIDMA_ERR_ALL_MASK			0x00000770
+
+//Interrupts, same bits in the control and the status register
+#define XAXIDMA_IRQ_IOC_MASK			0x00001000
+#define XAXIDMA_IRQ_DELAY_MASK			0x00002000
+#define XAXIDMA_IRQ_ERROR_MASK			0x00004000
+#define XAXIDMA_IRQ_ALL_MASK			0x00007000
+
+//Buffer descriptor
+#define XAXIDMA_BD_NDESC_OFFSET			0x00
+#define XAXIDMA_BD_BUFA_OFFSET			0x08
+#define XAXIDMA_BD_CTRL_LEN_OFFSET		0x18
+#define XAXIDMA_BD_STS_OFFSET			0x1C
+#define XAXIDMA_BD_CTRL_LENGTH_MASK		0x03FFFFFF
+#define XAXIDMA_BD_CTRL_TXSOF_MASK		0x08000000
+#define XAXIDMA_BD_CTRL_TXEOF_MASK		0x04000000
+#define XAXIDMA_BD_STS_COMPLETE_MASK	0x80000000
+#define XAXIDMA_BD_MINIMUM_ALIGNMENT	0x40
+
+#endif /* XAXIDMA_HW_H */
+
+/*************************************************************
+* End of file
+*************************************************************/
@@ -0,0 +1,18 @@
+/**************************************************************
+ * File: xdebug.h
+ * Description: Host simulation stand-in for the debug macros.
+ *
+ * Author: Ahac Rafael Bela
+ * Created on: 30.04.2025
+ * Last modified: 30.04.2025
+ *************************************************************/
+//Protection macro
+#pragma once
+#ifndef XDEBUG_H
+#define XDEBUG_H
+
+#endif /* XDEBUG_H */
+
+/*************************************************************
+* End of file
+*************************************************************/
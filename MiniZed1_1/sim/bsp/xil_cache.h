@@ -0,0 +1,31 @@
+/**************************************************************
+ * File: xil_cache.h
+ * Description: Host simulation stand-in for the cache
+ * maintenance, which only counts the work asked for.
+ *
+ * Author: Ahac Rafael Bela
+ * Created on: 30.04.2025
+ * Last modified: 30.04.2025
+ *************************************************************/
+//Protection macro
+#pragma once
+#ifndef XIL_CACHE_H
+#define XIL_CACHE_H
+
+/*************************************************************
+* Include section
+*************************************************************/
+#include "xil_types.h"
+
+/*************************************************************
+* Function prototype section
+*************************************************************/
+void Xil_DCacheFlush(void);
+void Xil_DCacheFlushRange(INTPTR adr, u32 len);
+void Xil_DCacheInvalidateRange(INTPTR adr, u32 len);
+
+#endif /* XIL_CACHE_H */
+
+/*************************************************************
+* End of file
+*************************************************************/
@@ -0,0 +1,42 @@
+/**************************************************************
+ * File: xil_exception.h
+ * Description: Host simulation stand-in for the ARM exception
+ * handling.
+ *
+ * Author: Ahac Rafael Bela
+ * Created on: 30.04.2025
+ * Last modified: 30.04.2025
+ *************************************************************/
+//Protection macro
+#pragma once
+#ifndef XIL_EXCEPTION_H
+#define XIL_EXCEPTION_H
+
+/*************************************************************
+* Include section
+*************************************************************/
+#include "xil_types.h"
+
+/*************************************************************
+* Macro section
+*************************************************************/
+#define XIL_EXCEPTION_ID_INT	5U
+
+/*************************************************************
+* Type section
+*************************************************************/
+typedef void (*Xil_ExceptionHandler)(void *data);
+typedef void (*Xil_InterruptHandler)(void *data);
+
+/*************************************************************
+* Function prototype section
+*************************************************************/
+void Xil_ExceptionRegisterHandler(u32 Exception_id, Xil_ExceptionHandler Handler, void *Data);
+void Xil_ExceptionEnable(void);
+void Xil_ExceptionDisable(void);
+
+#endif /* XIL_EXCEPTION_H */
+
+/*************************************************************
+* End of file
+*************************************************************/
@@ -0,0 +1,32 @@
+/**************************************************************
+ * File: xil_io.h
+ * Description: Host simulation stand-in for register access,
+ * routed to the peripheral models.
+ *
+ * Author: Ahac Rafael Bela
+ * Created on: 30.04.2025
+ * Last modified: 30.04.2025
+ *************************************************************/
+//Protection macro
+#pragma once
+#ifndef XIL_IO_H
+#define XIL_IO_H
+
+/*************************************************************
+* Include section
+*************************************************************/
+#include "xil_types.h"
+
+/*************************************************************
+* Function prototype section
+*************************************************************/
+//Writes a peripheral register.
+void Xil_Out32(UINTPTR addr, u32 value);
+//Reads a peripheral register.
+u32 Xil_In32(UINTPTR addr);
+
+#endif /* XIL_IO_H */
+
+/*************************************************************
+* End of file
+*************************************************************/
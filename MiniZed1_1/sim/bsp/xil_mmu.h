@@ -0,0 +1,39 @@
+/**************************************************************
+ * File: xil_mmu.h
+ * Description: Host simulation stand-in for the MMU section
+ * attributes, which only counts the changes asked for.
+ *
+ * Author: Ahac Rafael Bela
+ * Created on: 03.05.2025
+ * Last modified: 03.05.2025
+ *************************************************************/
+//Protection macro
+#pragma once
+#ifndef XIL_MMU_H
+#define XIL_MMU_H
+
+/*************************************************************
+* Include section
+*************************************************************/
+#include "xil_types.h"
+
+/*************************************************************
+* Macro section
+*************************************************************/
+//Section attributes of the Cortex-A9 translation table
+#define STRONG_ORDERED		0xC02
+#define DEVICE_MEMORY		0xC06
+#define NORM_NONCACHE		0x11DE2
+#define NORM_WT_CACHE		0x16DE6
+#define NORM_WB_CACHE		0x15DE6
+
+/*************************************************************
+* Function prototype section
+*************************************************************/
+void Xil_SetTlbAttributes(UINTPTR Addr, u32 attrib);
+
+#endif /* XIL_MMU_H */
+
+/*************************************************************
+* End of file
+*************************************************************/
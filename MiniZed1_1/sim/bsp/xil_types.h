@@ -0,0 +1,47 @@
+/**************************************************************
+ * File: xil_types.h
+ * Description: Host simulation stand-in for the standalone BSP
+ * basic types.
+ *
+ * Author: Ahac Rafael Bela
+ * Created on: 30.04.2025
+ * Last modified: 30.04.2025
+ *************************************************************/
+//Protection macro
+#pragma once
+#ifndef XIL_TYPES_H
+#define XIL_TYPES_H
+
+/*************************************************************
+* Include section
+*************************************************************/
+#include <stdint.h>
+#include <stddef.h>
+
+/*************************************************************
+* Type section
+*************************************************************/
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t s8;
+typedef int16_t s16;
+typedef int32_t s32;
+typedef int64_t s64;
+typedef uintptr_t UINTPTR;
+typedef intptr_t INTPTR;
+
+/*************************************************************
+* Macro section
+*************************************************************/
+#define XST_SUCCESS		0L
+#define XST_FAILURE		1L
+#define TRUE			1U
+#define FALSE			0U
+
+#endif /* XIL_TYPES_H */
+
+/*************************************************************
+* End of file
+*************************************************************/
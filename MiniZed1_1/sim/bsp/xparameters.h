@@ -0,0 +1,37 @@
+/**************************************************************
+ * File: xparameters.h
+ * Description: Host simulation stand-in for the generated
+ * hardware parameters of the MiniZed design.
+ *
+ * Author: Ahac Rafael Bela
+ * Created on: 30.04.2025
+ * Last modified: 17.05.2025
+ *************************************************************/
+//Protection macro
+#pragma once
+#ifndef XPARAMETERS_H
+#define XPARAMETERS_H
+
+/*************************************************************
+* Macro section
+*************************************************************/
+#define XPAR_AXIDMA_0_DEVICE_ID			0U
+#define XPAR_AXIDMA_0_BASEADDR			0x40400000U
+#define XPAR_AXI_GPIO_0_BASEADDR		0x41200000U
+//Timing generator mode select, the hardware design of the board has none
+#ifndef SIM_NO_MODE_SELECT
+#define XPAR_AXI_GPIO_1_BASEADDR		0x41210000U
+#endif
+#define XPAR_SCUGIC_SINGLE_DEVICE_ID	0U
+#define XPAR_SCUGIC_CPU_BASEADDR		0xF8F00100U
+#define XPAR_XUARTPS_1_DEVICE_ID		1U
+#define XPAR_XUARTPS_1_BASEADDR			0xE0001000U
+#define XPAR_XUARTPS_1_INTR				82U
+#define XPAR_PS7_DDR_0_S_AXI_BASEADDR	0x00100000U
+#define XPAR_PS7_DDR_0_S_AXI_HIGHADDR	0x1FFFFFFFU
+
+#endif /* XPARAMETERS_H */
+
+/*************************************************************
+* End of file
+*************************************************************/
@@ -0,0 +1,55 @@
+/**************************************************************
+ * File: xscugic.h
+ * Description: Host simulation stand-in for the SCU GIC driver.
+ *
+ * Author: Ahac Rafael Bela
+ * Created on: 30.04.2025
+ * Last modified: 30.04.2025
+ *************************************************************/
+//Protection macro
+#pragma once
+#ifndef XSCUGIC_H
+#define XSCUGIC_H
+
+/*************************************************************
+* Include section
+*************************************************************/
+#include "xil_exception.h"
+
+/*************************************************************
+* Macro section
+*************************************************************/
+#define XSCUGIC_MAX_NUM_INTR_INPUTS	95U
+
+/*************************************************************
+* Struct section
+*************************************************************/
+typedef struct {
+	u16 DeviceId;
+	u32 CpuBaseAddress;
+	u32 DistBaseAddress;
+} XScuGic_Config;
+
+typedef struct {
+	XScuGic_Config *Config;
+	u32 IsReady;
+	u32 UnhandledInterrupts;
+} XScuGic;
+
+/*************************************************************
+* Function prototype section
+*************************************************************/
+XScuGic_Config *XScuGic_LookupConfig(u16 DeviceId);
+s32 XScuGic_CfgInitialize(XScuGic *InstancePtr, XScuGic_Config *ConfigPtr, u32 EffectiveAddr);
+s32 XScuGic_SelfTest(XScuGic *InstancePtr);
+void XScuGic_SetPriorityTriggerType(XScuGic *InstancePtr, u32 Int_Id, u8 Priority, u8 Trigger);
+s32 XScuGic_Connect(XScuGic *InstancePtr, u32 Int_Id, Xil_InterruptHandler Handler, void *CallBackRef);
+void XScuGic_Enable(XScuGic *InstancePtr, u32 Int_Id);
+void XScuGic_Disable(XScuGic *InstancePtr, u32 Int_Id);
+void XScuGic_InterruptHandler(XScuGic *InstancePtr);
+
+#endif /* XSCUGIC_H */
+
+/*************************************************************
+* End of file
+*************************************************************/
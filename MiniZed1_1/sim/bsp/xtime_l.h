@@ -0,0 +1,40 @@
+/**************************************************************
+ * File: xtime_l.h
+ * Description: Host simulation stand-in for the global timer,
+ * counting simulated time.
+ *
+ * Author: Ahac Rafael Bela
+ * Created on: 30.04.2025
+ * Last modified: 30.04.2025
+ *************************************************************/
+//Protection macro
+#pragma once
+#ifndef XTIME_L_H
+#define XTIME_L_H
+
+/*************************************************************
+* Include section
+*************************************************************/
+#include "xil_types.h"
+
+/*************************************************************
+* Macro section
+*************************************************************/
+//Global timer runs at half the 666.67 MHz CPU clock
+#define COUNTS_PER_SECOND	333333333ULL
+
+/*************************************************************
+* Type section
+*************************************************************/
+typedef u64 XTime;
+
+/*************************************************************
+* Function prototype section
+*************************************************************/
+void XTime_GetTime(XTime *Xtime_Global);
+
+#endif /* XTIME_L_H */
+
+/*************************************************************
+* End of file
+*************************************************************/
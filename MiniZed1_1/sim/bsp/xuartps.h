@@ -0,0 +1,67 @@
+/**************************************************************
+ * File: xuartps.h
+ * Description: Host simulation stand-in for the UART PS driver.
+ *
+ * Author: Ahac Rafael Bela
+ * Created on: 30.04.2025
+ * Last modified: 30.04.2025
+ *************************************************************/
+//Protection macro
+#pragma once
+#ifndef XUARTPS_H
+#define XUARTPS_H
+
+/*************************************************************
+* Include section
+*************************************************************/
+#include "xil_types.h"
+
+/*************************************************************
+* Macro section
+*************************************************************/
+#define XUARTPS_OPER_MODE_NORMAL	0x00U
+#define XUARTPS_IXR_RXOVR			0x00000001U
+#define XUARTPS_IXR_MASK			0x00003FFFU
+#define XUARTPS_EVENT_RECV_DATA		1U
+
+/*************************************************************
+* Type section
+*************************************************************/
+typedef void (*XUartPs_Handler)(void *CallBackRef, u32 Event, u32 EventData);
+
+/*************************************************************
+* Struct section
+*************************************************************/
+typedef struct {
+	u16 DeviceId;
+	u32 BaseAddress;
+	u32 InputClockHz;
+} XUartPs_Config;
+
+typedef struct {
+	XUartPs_Config Config;
+	u32 IsReady;
+	u8 *ReceiveBuffer;			//Where the next received bytes go
+	u32 ReceiveRemaining;		//Bytes still expected by XUartPs_Recv
+	XUartPs_Handler Handler;
+	void *CallBackRef;
+} XUartPs;
+
+/*************************************************************
+* Function prototype section
+*************************************************************/
+XUartPs_Config *XUartPs_LookupConfig(u16 DeviceId);
+s32 XUartPs_CfgInitialize(XUartPs *InstancePtr, XUartPs_Config *Config, u32 EffectiveAddr);
+s32 XUartPs_SetBaudRate(XUartPs *InstancePtr, u32 BaudRate);
+void XUartPs_SetOperMode(XUartPs *InstancePtr, u8 OperationMode);
+void XUartPs_SetInterruptMask(XUartPs *InstancePtr, u32 Mask);
+void XUartPs_SetHandler(XUartPs *InstancePtr, XUartPs_Handler FuncPtr, void *CallBackRef);
+void XUartPs_SetFifoThreshold(XUartPs *InstancePtr, u8 TriggerLevel);
+u32 XUartPs_Recv(XUartPs *InstancePtr, u8 *BufferPtr, u32 NumBytes);
+void XUartPs_InterruptHandler(XUartPs *InstancePtr);
+
+#endif /* XUARTPS_H */
+
+/*************************************************************
+* End of file
+*************************************************************/
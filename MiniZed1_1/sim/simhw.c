@@ -0,0 +1,823 @@
+/**************************************************************
+ * File: simhw.c
+ * Description: Register-level host models of the AXI DMA,
+ * SCU GIC and UART PS used by the MiniZed simulator, together
+ * with the BSP driver functions the application calls.
+ *
+ * Author: Ahac Rafael Bela
+ * Created on: 30.04.2025
+ * Last modified: 17.05.2025
+ *************************************************************/
+
+/*************************************************************
+* Include section
+*************************************************************/
+#include "simhw.h"
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/*************************************************************
+* Macro section
+*************************************************************/
+//Interrupt lines of the DMA in the hardware design
+#define SIM_MM2S_INTR		61U
+#define SIM_S2MM_INTR		62U
+//Size of the DMA register space, both channels
+#define SIM_DMA_SPAN		0x60U
+
+//Buffer descriptor words, see sgDescriptor
+#define SIM_BD_NEXT			(XAXIDMA_BD_NDESC_OFFSET / 4)
+#define SIM_BD_BUFFER		(XAXIDMA_BD_BUFA_OFFSET / 4)
+#define SIM_BD_CONTROL		(XAXIDMA_BD_CTRL_LEN_OFFSET / 4)
+#define SIM_BD_STATUS		(XAXIDMA_BD_STS_OFFSET / 4)
+
+/*************************************************************
+* Struct section
+*************************************************************/
+typedef struct simChannel_t {
+	u32 cr;					//Control register
+	u32 sr;					//Status register
+	u32 cdesc;				//Current descriptor register
+	u32 tdesc;				//Tail descriptor register
+	u32 addr;				//Source or destination address register
+	u32 length;				//Buffer length register
+	u32 busy;				//A transfer is in flight or armed
+	u32 fail;				//The transfer in flight ends with a slave error
+	u32 xferAddr;			//Address of the transfer in flight
+	u32 xferLength;			//Length of the transfer in flight
+	u64 doneAt;				//Completion time of the transfer in flight
+	u32 bursts;				//Bursts of the transfer in flight
+	u64 duration;			//Duration of the transfer in flight
+	u32 sgNext;				//Next descriptor to fetch in SG mode
+	u32 sgActive;			//Descriptor in flight in SG mode
+	u32 intrId;				//Interrupt line of the channel
+} simChannel;
+
+typedef struct simGicLine_t {
+	Xil_InterruptHandler handler;	//Connected handler
+	void *ref;						//Callback reference of the handler
+	u8 priority;					//Priority, lower is more urgent
+	u8 enabled;						//Forwarded to the CPU
+	u8 pending;						//Raised and not yet handled
+	u8 mainMasked;					//Disabled by the main context, which holds the lock
+} simGicLine;
+
+/*************************************************************
+* Global variable section
+*************************************************************/
+simConfig simCfg = {0, SIM_DMA_BANDWIDTH, 0};
+volatile u64 simTime = 0;
+simCounters simCount;
+simIsrStats simIsr[SIM_MAX_INTR];
+simSinkHandler simSink = NULL;
+volatile u32 simTimingMode = 0;
+
+static pthread_mutex_t simMutex;
+static pthread_once_t simMutexOnce = PTHREAD_ONCE_INIT;
+static pthread_t hardwareThread;
+static u32 hardwareThreadSet = 0;
+
+static simChannel channels[2];
+static u32 loopbackSel = 0;
+static u32 mm2sStarted = 0;
+static XAxiDma_Config dmaConfig;
+
+static simGicLine gic[SIM_MAX_INTR];
+static u32 exceptionsEnabled = 0;
+static XScuGic_Config gicConfig = {XPAR_SCUGIC_SINGLE_DEVICE_ID, XPAR_SCUGIC_CPU_BASEADDR, 0xF8F01000U};
+
+static XUartPs_Config uartConfig = {XPAR_XUARTPS_1_DEVICE_ID, XPAR_XUARTPS_1_BASEADDR, 100000000U};
+static XUartPs *uart = NULL;
+static u8 uartChar;
+static u32 uartHasChar = 0;
+
+/*************************************************************
+* Function definition section
+*************************************************************/
+
+/*************************************************************
+* simMutexInit creates the recursive lock of the models.
+*************************************************************/
+static void simMutexInit(void) {
+	pthread_mutexattr_t attr;
+
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(&simMutex, &attr);
+	pthread_mutexattr_destroy(&attr);
+}
+
+/*************************************************************
+* simLock takes the lock of the hardware models. The hardware
+* 			thread holds it while time advances and handlers
+* 			run, the main context while it masks an interrupt.
+*
+* @param	None.
+*
+* @return	None.
+*
+* @note		The lock is recursive.
+*************************************************************/
+void simLock(void) {
+	pthread_once(&simMutexOnce, simMutexInit);
+	pthread_mutex_lock(&simMutex);
+}
+
+/*************************************************************
+* simUnlock releases the lock of the hardware models.
+*
+* @param	None.
+*
+* @return	None.
+*
+* @note		None.
+*************************************************************/
+void simUnlock(void) {
+	pthread_mutex_unlock(&simMutex);
+}
+
+/*************************************************************
+* simSetHardwareThread marks the calling thread as the one that
+* 			advances time and runs interrupt handlers.
+*
+* @param	None.
+*
+* @return	None.
+*
+* @note		Every other thread is the main context of the CPU.
+*************************************************************/
+void simSetHardwareThread(void) {
+	hardwareThread = pthread_self();
+	hardwareThreadSet = 1;
+}
+
+/*************************************************************
+* inHandler tells if the caller runs on the hardware thread.
+*************************************************************/
+static int inHandler(void) {
+	return hardwareThreadSet && pthread_equal(pthread_self(), hardwareThread);
+}
+
+/*************************************************************
+* hostTime returns the host monotonic clock in ns.
+*************************************************************/
+static u64 hostTime(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (u64) ts.tv_sec * 1000000000ULL + (u64) ts.tv_nsec;
+}
+
+/*************************************************************
+* simRaise raises an interrupt in the GIC model.
+*
+* @param	intrId is the interrupt to raise.
+*
+* @return	None.
+*
+* @note		Lines behave as edge triggered, the handler runs once
+* 			per raise as soon as the line is enabled.
+*************************************************************/
+void simRaise(u32 intrId) {
+	if(intrId >= SIM_MAX_INTR) return;
+	simLock();
+	gic[intrId].pending = 1;
+	simUnlock();
+}
+
+/*************************************************************
+* simDispatch runs the handlers of pending and enabled interrupts,
+* 			most urgent priority first, and accounts their cost.
+*
+* @param	None.
+*
+* @return	None.
+*
+* @note		Handlers do not nest, like the standalone BSP. Virtual
+* 			time stands still while they run, their host time and
+* 			register accesses are recorded instead.
+*************************************************************/
+void simDispatch(void) {
+	simLock();
+	while(exceptionsEnabled) {
+		s32 best = -1;
+		for(u32 i = 0; i < SIM_MAX_INTR; i++) {
+			if(!gic[i].pending || !gic[i].enabled) continue;
+			if(best < 0 || gic[i].priority < gic[best].priority) best = i;
+		}
+		if(best < 0) break;
+
+		gic[best].pending = 0;
+		if(!gic[best].handler) {
+			simCount.spuriousInterrupts++;
+			continue;
+		}
+		u64 accesses = simCount.registerReads + simCount.registerWrites;
+		u64 start = hostTime();
+		gic[best].handler(gic[best].ref);
+		u64 spent = hostTime() - start;
+
+		simIsr[best].calls++;
+		simIsr[best].hostTime += spent;
+		if(spent > simIsr[best].maxHostTime) simIsr[best].maxHostTime = spent;
+		simIsr[best].registerAccesses += simCount.registerReads + simCount.registerWrites - accesses;
+	}
+	simUnlock();
+}
+
+/*************************************************************
+* DMA model
+*************************************************************/
+
+/*************************************************************
+* dmaTiming works out the bursts and the duration of the transfer
+* 			in flight. Every burst-sized block it touches costs a
+* 			burst, so unaligned transfers need more of them.
+*************************************************************/
+static void dmaTiming(simChannel *ch) {
+	u32 last = ch->xferAddr + ch->xferLength - 1;
+
+	ch->bursts = last / SIM_BURST_BYTES - ch->xferAddr / SIM_BURST_BYTES + 1;
+	ch->duration = (u64) ch->bursts * SIM_BURST_SETUP + (u64) ch->xferLength * 1000 / simCfg.bandwidth;
+	simCount.mm2sBursts += ch->bursts;
+	if((ch->xferAddr ^ last) & ~(SIM_BURST_BOUNDARY - 1)) simCount.mm2sCrossings++;
+}
+
+/*************************************************************
+* dmaInterrupt sets interrupt bits of a channel and raises its
+* 			line if they are enabled in the control register.
+*************************************************************/
+static void dmaInterrupt(simChannel *ch, u32 mask) {
+	ch->sr |= mask;
+	if(ch->cr & mask) simRaise(ch->intrId);
+}
+
+/*************************************************************
+* dmaError halts a channel with the given error bits.
+*************************************************************/
+static void dmaError(simChannel *ch, u32 errors) {
+	ch->busy = 0;
+	ch->fail = 0;
+	ch->doneAt = SIM_NEVER;
+	ch->cr &= ~XAXIDMA_CR_RUNSTOP_MASK;
+	ch->sr |= errors | XAXIDMA_HALTED_MASK;
+	simCount.dmaErrors++;
+	dmaInterrupt(ch, XAXIDMA_IRQ_ERROR_MASK);
+}
+
+/*************************************************************
+* dmaReset puts both channels in their reset state.
+*************************************************************/
+static void dmaReset(void) {
+	for(u32 i = 0; i < 2; i++) {
+		u32 intrId = channels[i].intrId;
+		memset(&channels[i], 0, sizeof(simChannel));
+		channels[i].sr = XAXIDMA_HALTED_MASK;
+		channels[i].doneAt = SIM_NEVER;
+		channels[i].intrId = intrId;
+	}
+}
+
+/*************************************************************
+* dmaStartMm2s starts a MM2S read of xferLength bytes.
+*************************************************************/
+static void dmaStartMm2s(simChannel *ch) {
+	ch->busy = 1;
+	ch->sr &= ~XAXIDMA_IDLE_MASK;
+	dmaTiming(ch);
+	ch->doneAt = simTime + ch->duration;
+	//Error injection counts every transfer, simple or descriptor
+	ch->fail = (simCfg.errorAt && ++mm2sStarted == simCfg.errorAt);
+}
+
+/*************************************************************
+* dmaFetchDescriptor starts the transfer of the next descriptor.
+*************************************************************/
+static void dmaFetchDescriptor(simChannel *ch) {
+	u32 *bd = (u32 *) (UINTPTR) ch->sgNext;
+
+	if(!bd) {
+		dmaError(ch, XAXIDMA_ERR_SG_DEC_MASK);
+		return;
+	}
+	//Descriptors still marked complete are refused
+	if(bd[SIM_BD_STATUS] & XAXIDMA_BD_STS_COMPLETE_MASK) {
+		dmaError(ch, XAXIDMA_ERR_SG_INT_MASK);
+		return;
+	}
+	ch->sgActive = ch->sgNext;
+	ch->xferAddr = bd[SIM_BD_BUFFER];
+	ch->xferLength = bd[SIM_BD_CONTROL] & XAXIDMA_BD_CTRL_LENGTH_MASK;
+	dmaStartMm2s(ch);
+}
+
+/*************************************************************
+* dmaCompleteMm2s delivers the data of the finished MM2S transfer
+* 			to the VGA output or loops it back into S2MM.
+*************************************************************/
+static void dmaCompleteMm2s(simChannel *ch) {
+	simChannel *rx = &channels[1];
+
+	if(ch->fail) {
+		dmaError(ch, XAXIDMA_ERR_SLAVE_MASK);
+		return;
+	}
+	simCount.mm2sTransfers++;
+	simCount.mm2sBytes += ch->xferLength;
+
+	if(loopbackSel && !simCfg.hasSg) {
+		if(!rx->busy || rx->xferLength < ch->xferLength) {
+			//Stream has nowhere to go, S2MM reports an internal error
+			dmaError(rx, XAXIDMA_ERR_INTERNAL_MASK);
+		} else {
+			memmove((void *) (UINTPTR) rx->xferAddr, (void *) (UINTPTR) ch->xferAddr, ch->xferLength);
+			simCount.s2mmBytes += ch->xferLength;
+			rx->busy = 0;
+			rx->sr |= XAXIDMA_IDLE_MASK;
+			dmaInterrupt(rx, XAXIDMA_IRQ_IOC_MASK);
+		}
+	} else {
+		simCount.vgaTransfers++;
+		simCount.vgaBytes += ch->xferLength;
+		simCount.vgaBursts += ch->bursts;
+		simCount.vgaTime += ch->duration;
+		if(simSink) simSink(ch->xferAddr, ch->xferLength, simTime);
+	}
+
+	ch->doneAt = SIM_NEVER;
+	if(simCfg.hasSg) {
+		u32 *bd = (u32 *) (UINTPTR) ch->sgActive;
+		bd[SIM_BD_STATUS] = XAXIDMA_BD_STS_COMPLETE_MASK | ch->xferLength;
+		ch->cdesc = ch->sgActive;
+		ch->sgNext = bd[SIM_BD_NEXT];
+		dmaInterrupt(ch, XAXIDMA_IRQ_IOC_MASK);
+		//Keep fetching until the tail descriptor is done
+		if(ch->sgActive != ch->tdesc && (ch->cr & XAXIDMA_CR_RUNSTOP_MASK)) {
+			dmaFetchDescriptor(ch);
+			return;
+		}
+	} else {
+		dmaInterrupt(ch, XAXIDMA_IRQ_IOC_MASK);
+	}
+	ch->busy = 0;
+	ch->sr |= XAXIDMA_IDLE_MASK;
+}
+
+/*************************************************************
+* simDmaNextEvent returns the time of the next DMA event.
+*
+* @param	None.
+*
+* @return	Completion time of the MM2S transfer in flight, or
+* 			SIM_NEVER when the channel is idle.
+*
+* @note		S2MM only completes together with a loopback MM2S
+* 			transfer, so it has no events of its own.
+*************************************************************/
+u64 simDmaNextEvent(void) {
+	return channels[0].busy ? channels[0].doneAt : SIM_NEVER;
+}
+
+/*************************************************************
+* simDmaAdvance finishes the DMA transfers due at simTime.
+*
+* @param	None.
+*
+* @return	None.
+*
+* @note		Raises the completion and error interrupts.
+*************************************************************/
+void simDmaAdvance(void) {
+	simLock();
+	if(channels[0].busy && channels[0].doneAt <= simTime) dmaCompleteMm2s(&channels[0]);
+	simUnlock();
+}
+
+/*************************************************************
+* dmaWrite handles a write to a DMA channel register.
+*************************************************************/
+static void dmaWrite(simChannel *ch, u32 reg, u32 value) {
+	switch(reg) {
+	case XAXIDMA_CR_OFFSET:
+		if(value & XAXIDMA_CR_RESET_MASK) {
+			//A reset of either channel resets the whole DMA and finishes at once
+			dmaReset();
+			break;
+		}
+		if(!(ch->cr & XAXIDMA_CR_RUNSTOP_MASK) && (value & XAXIDMA_CR_RUNSTOP_MASK)) {
+			ch->sr &= ~XAXIDMA_HALTED_MASK;
+			if(!ch->busy) ch->sr |= XAXIDMA_IDLE_MASK;
+			ch->sgNext = ch->cdesc;
+		}
+		if(!(value & XAXIDMA_CR_RUNSTOP_MASK)) ch->sr |= XAXIDMA_HALTED_MASK;
+		ch->cr = value;
+		break;
+	case XAXIDMA_SR_OFFSET:
+		//Interrupt bits are cleared by writing 1
+		ch->sr &= ~(value & XAXIDMA_IRQ_ALL_MASK);
+		break;
+	case XAXIDMA_CDESC_OFFSET:
+		if(ch->sr & XAXIDMA_HALTED_MASK) ch->cdesc = value;
+		break;
+	case XAXIDMA_TDESC_OFFSET:
+		ch->tdesc = value;
+		if(simCfg.hasSg && ch == &channels[0] && !ch->busy && (ch->cr & XAXIDMA_CR_RUNSTOP_MASK)) {
+			dmaFetchDescriptor(ch);
+		}
+		break;
+	case XAXIDMA_SRCADDR_OFFSET:
+		ch->addr = value;
+		break;
+	case XAXIDMA_BUFFLEN_OFFSET:
+		ch->length = value;
+		if(simCfg.hasSg || !(ch->cr & XAXIDMA_CR_RUNSTOP_MASK)) break;
+		if(value == 0 || ch->busy) {
+			dmaError(ch, XAXIDMA_ERR_INTERNAL_MASK);
+			break;
+		}
+		ch->xferAddr = ch->addr;
+		ch->xferLength = value;
+		if(ch == &channels[0]) dmaStartMm2s(ch);
+		else {
+			//S2MM waits for the stream
+			ch->busy = 1;
+			ch->sr &= ~XAXIDMA_IDLE_MASK;
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+/*************************************************************
+* dmaRead handles a read of a DMA channel register.
+*************************************************************/
+static u32 dmaRead(simChannel *ch, u32 reg) {
+	switch(reg) {
+	case XAXIDMA_CR_OFFSET: return ch->cr;
+	case XAXIDMA_SR_OFFSET: return ch->sr;
+	case XAXIDMA_CDESC_OFFSET: return ch->cdesc;
+	case XAXIDMA_TDESC_OFFSET: return ch->tdesc;
+	case XAXIDMA_SRCADDR_OFFSET: return ch->addr;
+	case XAXIDMA_BUFFLEN_OFFSET: return ch->length;
+	default: return 0;
+	}
+}
+
+/*************************************************************
+* Xil_Out32 writes a peripheral register of the models.
+*
+* @param	addr is the register address.
+* @param	value is the value to write.
+*
+* @return	None.
+*
+* @note		Writes outside the modelled peripherals are ignored.
+*************************************************************/
+void Xil_Out32(UINTPTR addr, u32 value) {
+	simLock();
+	simCount.registerWrites++;
+	if(addr >= XPAR_AXIDMA_0_BASEADDR && addr < XPAR_AXIDMA_0_BASEADDR + SIM_DMA_SPAN) {
+		u32 offset = addr - XPAR_AXIDMA_0_BASEADDR;
+		u32 rx = offset >= XAXIDMA_RX_OFFSET;
+		dmaWrite(&channels[rx], offset - rx * XAXIDMA_RX_OFFSET, value);
+	} else if(addr == XPAR_AXI_GPIO_0_BASEADDR) {
+		loopbackSel = value & 1;
+#ifdef XPAR_AXI_GPIO_1_BASEADDR
+	} else if(addr == XPAR_AXI_GPIO_1_BASEADDR) {
+		simTimingMode = value;
+#endif
+	}
+	simUnlock();
+}
+
+/*************************************************************
+* Xil_In32 reads a peripheral register of the models.
+*
+* @param	addr is the register address.
+*
+* @return	The register value, 0 outside the modelled peripherals.
+*
+* @note		None.
+*************************************************************/
+u32 Xil_In32(UINTPTR addr) {
+	u32 value = 0;
+
+	simLock();
+	simCount.registerReads++;
+	if(addr >= XPAR_AXIDMA_0_BASEADDR && addr < XPAR_AXIDMA_0_BASEADDR + SIM_DMA_SPAN) {
+		u32 offset = addr - XPAR_AXIDMA_0_BASEADDR;
+		u32 rx = offset >= XAXIDMA_RX_OFFSET;
+		value = dmaRead(&channels[rx], offset - rx * XAXIDMA_RX_OFFSET);
+	} else if(addr == XPAR_AXI_GPIO_0_BASEADDR) {
+		value = loopbackSel;
+#ifdef XPAR_AXI_GPIO_1_BASEADDR
+	} else if(addr == XPAR_AXI_GPIO_1_BASEADDR) {
+		value = simTimingMode;
+#endif
+	}
+	simUnlock();
+
+	return value;
+}
+
+/*************************************************************
+* AXI DMA driver
+*************************************************************/
+XAxiDma_Config *XAxiDma_LookupConfig(u32 DeviceId) {
+	if(DeviceId != XPAR_AXIDMA_0_DEVICE_ID) return NULL;
+	dmaConfig.DeviceId = DeviceId;
+	dmaConfig.BaseAddr = XPAR_AXIDMA_0_BASEADDR;
+	dmaConfig.HasMm2s = 1;
+	dmaConfig.HasS2Mm = 1;
+	dmaConfig.Mm2SDataWidth = 32;
+	dmaConfig.S2MmDataWidth = 32;
+	dmaConfig.HasSg = simCfg.hasSg;
+	return &dmaConfig;
+}
+
+int XAxiDma_CfgInitialize(XAxiDma *InstancePtr, XAxiDma_Config *Config) {
+	InstancePtr->RegBase = Config->BaseAddr;
+	InstancePtr->HasMm2s = Config->HasMm2s;
+	InstancePtr->HasS2Mm = Config->HasS2Mm;
+	InstancePtr->HasSg = Config->HasSg;
+	channels[0].intrId = SIM_MM2S_INTR;
+	channels[1].intrId = SIM_S2MM_INTR;
+	XAxiDma_Reset(InstancePtr);
+	InstancePtr->Initialized = 1;
+	return XST_SUCCESS;
+}
+
+void XAxiDma_Reset(XAxiDma *InstancePtr) {
+	Xil_Out32(InstancePtr->RegBase + XAXIDMA_CR_OFFSET, XAXIDMA_CR_RESET_MASK);
+}
+
+int XAxiDma_ResetIsDone(XAxiDma *InstancePtr) {
+	return !(Xil_In32(InstancePtr->RegBase + XAXIDMA_CR_OFFSET) & XAXIDMA_CR_RESET_MASK);
+}
+
+void XAxiDma_IntrEnable(XAxiDma *InstancePtr, u32 Mask, int Direction) {
+	UINTPTR cr = InstancePtr->RegBase + Direction * XAXIDMA_RX_OFFSET + XAXIDMA_CR_OFFSET;
+	Xil_Out32(cr, Xil_In32(cr) | (Mask & XAXIDMA_IRQ_ALL_MASK));
+}
+
+void XAxiDma_IntrDisable(XAxiDma *InstancePtr, u32 Mask, int Direction) {
+	UINTPTR cr = InstancePtr->RegBase + Direction * XAXIDMA_RX_OFFSET + XAXIDMA_CR_OFFSET;
+	Xil_Out32(cr, Xil_In32(cr) & ~(Mask & XAXIDMA_IRQ_ALL_MASK));
+}
+
+u32 XAxiDma_IntrGetIrq(XAxiDma *InstancePtr, int Direction) {
+	return Xil_In32(InstancePtr->RegBase + Direction * XAXIDMA_RX_OFFSET + XAXIDMA_SR_OFFSET) & XAXIDMA_IRQ_ALL_MASK;
+}
+
+void XAxiDma_IntrAckIrq(XAxiDma *InstancePtr, u32 Mask, int Direction) {
+	Xil_Out32(InstancePtr->RegBase + Direction * XAXIDMA_RX_OFFSET + XAXIDMA_SR_OFFSET, Mask & XAXIDMA_IRQ_ALL_MASK);
+}
+
+/*************************************************************
+* SCU GIC driver
+*************************************************************/
+XScuGic_Config *XScuGic_LookupConfig(u16 DeviceId) {
+	return DeviceId == XPAR_SCUGIC_SINGLE_DEVICE_ID ? &gicConfig : NULL;
+}
+
+s32 XScuGic_CfgInitialize(XScuGic *InstancePtr, XScuGic_Config *ConfigPtr, u32 EffectiveAddr) {
+	(void) EffectiveAddr;
+	InstancePtr->Config = ConfigPtr;
+	InstancePtr->IsReady = 1;
+	return XST_SUCCESS;
+}
+
+s32 XScuGic_SelfTest(XScuGic *InstancePtr) {
+	(void) InstancePtr;
+	return XST_SUCCESS;
+}
+
+void XScuGic_SetPriorityTriggerType(XScuGic *InstancePtr, u32 Int_Id, u8 Priority, u8 Trigger) {
+	(void) InstancePtr;
+	(void) Trigger;
+	if(Int_Id >= SIM_MAX_INTR) return;
+	simLock();
+	gic[Int_Id].priority = Priority;
+	simUnlock();
+}
+
+s32 XScuGic_Connect(XScuGic *InstancePtr, u32 Int_Id, Xil_InterruptHandler Handler, void *CallBackRef) {
+	(void) InstancePtr;
+	if(Int_Id >= SIM_MAX_INTR) return XST_FAILURE;
+	simLock();
+	gic[Int_Id].handler = Handler;
+	gic[Int_Id].ref = CallBackRef;
+	simUnlock();
+	return XST_SUCCESS;
+}
+
+/*************************************************************
+* XScuGic_Enable forwards an interrupt to the CPU again. When the
+* 			main context enables a line it masked, it gives back
+* 			the lock so time moves on.
+*************************************************************/
+void XScuGic_Enable(XScuGic *InstancePtr, u32 Int_Id) {
+	(void) InstancePtr;
+	if(Int_Id >= SIM_MAX_INTR) return;
+	simLock();
+	simCount.registerWrites++;
+	gic[Int_Id].enabled = 1;
+	if(!inHandler() && gic[Int_Id].mainMasked) {
+		gic[Int_Id].mainMasked = 0;
+		simUnlock();
+	}
+	simUnlock();
+}
+
+/*************************************************************
+* XScuGic_Disable stops forwarding an interrupt to the CPU. When
+* 			the main context masks a line it keeps the lock
+* 			until the line is enabled again, so neither the
+* 			handler nor time can run inside its critical section.
+*************************************************************/
+void XScuGic_Disable(XScuGic *InstancePtr, u32 Int_Id) {
+	(void) InstancePtr;
+	if(Int_Id >= SIM_MAX_INTR) return;
+	simLock();
+	simCount.registerWrites++;
+	gic[Int_Id].enabled = 0;
+	if(!inHandler() && !gic[Int_Id].mainMasked) {
+		gic[Int_Id].mainMasked = 1;
+		return;
+	}
+	simUnlock();
+}
+
+void XScuGic_InterruptHandler(XScuGic *InstancePtr) {
+	(void) InstancePtr;
+	simDispatch();
+}
+
+/*************************************************************
+* Exceptions
+*************************************************************/
+void Xil_ExceptionRegisterHandler(u32 Exception_id, Xil_ExceptionHandler Handler, void *Data) {
+	(void) Exception_id;
+	(void) Handler;
+	(void) Data;
+}
+
+void Xil_ExceptionEnable(void) {
+	exceptionsEnabled = 1;
+}
+
+void Xil_ExceptionDisable(void) {
+	exceptionsEnabled = 0;
+}
+
+/*************************************************************
+* UART PS driver
+*************************************************************/
+XUartPs_Config *XUartPs_LookupConfig(u16 DeviceId) {
+	return DeviceId == XPAR_XUARTPS_1_DEVICE_ID ? &uartConfig : NULL;
+}
+
+s32 XUartPs_CfgInitialize(XUartPs *InstancePtr, XUartPs_Config *Config, u32 EffectiveAddr) {
+	(void) EffectiveAddr;
+	memset(InstancePtr, 0, sizeof(XUartPs));
+	InstancePtr->Config = *Config;
+	InstancePtr->IsReady = 1;
+	uart = InstancePtr;
+	return XST_SUCCESS;
+}
+
+s32 XUartPs_SetBaudRate(XUartPs *InstancePtr, u32 BaudRate) {
+	(void) InstancePtr;
+	(void) BaudRate;
+	return XST_SUCCESS;
+}
+
+void XUartPs_SetOperMode(XUartPs *InstancePtr, u8 OperationMode) {
+	(void) InstancePtr;
+	(void) OperationMode;
+}
+
+void XUartPs_SetInterruptMask(XUartPs *InstancePtr, u32 Mask) {
+	(void) InstancePtr;
+	(void) Mask;
+}
+
+void XUartPs_SetHandler(XUartPs *InstancePtr, XUartPs_Handler FuncPtr, void *CallBackRef) {
+	InstancePtr->Handler = FuncPtr;
+	InstancePtr->CallBackRef = CallBackRef;
+}
+
+void XUartPs_SetFifoThreshold(XUartPs *InstancePtr, u8 TriggerLevel) {
+	(void) InstancePtr;
+	(void) TriggerLevel;
+}
+
+u32 XUartPs_Recv(XUartPs *InstancePtr, u8 *BufferPtr, u32 NumBytes) {
+	simLock();
+	InstancePtr->ReceiveBuffer = BufferPtr;
+	InstancePtr->ReceiveRemaining = NumBytes;
+	simUnlock();
+	return 0;
+}
+
+/*************************************************************
+* XUartPs_InterruptHandler stores the received character and
+* 			reports it to the handler set by XUartPs_SetHandler.
+*************************************************************/
+void XUartPs_InterruptHandler(XUartPs *InstancePtr) {
+	if(!uartHasChar || !InstancePtr->ReceiveBuffer) return;
+	uartHasChar = 0;
+	*InstancePtr->ReceiveBuffer = uartChar;
+	InstancePtr->ReceiveBuffer = NULL;
+	InstancePtr->ReceiveRemaining = 0;
+	if(InstancePtr->Handler) InstancePtr->Handler(InstancePtr->CallBackRef, XUARTPS_EVENT_RECV_DATA, 1);
+}
+
+/*************************************************************
+* simUartReceive receives a character on the UART.
+*
+* @param	c is the character.
+*
+* @return
+* 			- 1 if the character was taken,
+* 			- 0 if nobody waits for it yet.
+*
+* @note		None.
+*************************************************************/
+int simUartReceive(u8 c) {
+	int taken = 0;
+
+	simLock();
+	if(uart && uart->ReceiveBuffer && !uartHasChar) {
+		uartChar = c;
+		uartHasChar = 1;
+		simRaise(XPAR_XUARTPS_1_INTR);
+		taken = 1;
+	}
+	simUnlock();
+	return taken;
+}
+
+/*************************************************************
+* Cache, timer, sleep and print
+*************************************************************/
+void Xil_DCacheFlush(void) {
+	simLock();
+	simCount.fullFlushes++;
+	simUnlock();
+}
+
+void Xil_DCacheFlushRange(INTPTR adr, u32 len) {
+	(void) adr;
+	simLock();
+	simCount.flushCalls++;
+	simCount.flushBytes += len;
+	simUnlock();
+}
+
+void Xil_DCacheInvalidateRange(INTPTR adr, u32 len) {
+	(void) adr;
+	simLock();
+	simCount.invalidateBytes += len;
+	simUnlock();
+}
+
+void Xil_SetTlbAttributes(UINTPTR Addr, u32 attrib) {
+	(void) Addr;
+	(void) attrib;
+	//The whole data cache is flushed after the table entry changes
+	simLock();
+	simCount.mappingChanges++;
+	simCount.fullFlushes++;
+	simUnlock();
+}
+
+void XTime_GetTime(XTime *Xtime_Global) {
+	*Xtime_Global = (XTime) ((unsigned __int128) simTime * COUNTS_PER_SECOND / 1000000000ULL);
+}
+
+int usleep(unsigned long useconds) {
+	(void) useconds;
+	return 0;
+}
+
+unsigned sleep(unsigned int seconds) {
+	(void) seconds;
+	return 0;
+}
+
+void xil_printf(const char *format, ...) {
+	va_list args;
+
+	va_start(args, format);
+	vprintf(format, args);
+	va_end(args);
+}
+
+/*************************************************************
+* End of file
+*************************************************************/
@@ -0,0 +1,119 @@
+/**************************************************************
+ * File: simhw.h
+ * Description: Register-level host models of the AXI DMA,
+ * SCU GIC and UART PS used by the MiniZed simulator.
+ *
+ * Author: Ahac Rafael Bela
+ * Created on: 30.04.2025
+ * Last modified: 06.05.2025
+ *************************************************************/
+//Protection macro
+#pragma once
+#ifndef SIMHW_H
+#define SIMHW_H
+
+/*************************************************************
+* Include section
+*************************************************************/
+#include "xparameters.h"
+#include "xaxidma.h"
+#include "xscugic.h"
+#include "xuartps.h"
+#include "xil_cache.h"
+#include "xil_mmu.h"
+#include "xtime_l.h"
+
+/*************************************************************
+* Macro section
+*************************************************************/
+//Number of interrupt IDs the GIC model knows
+#define SIM_MAX_INTR			(XSCUGIC_MAX_NUM_INTR_INPUTS + 1)
+//No event pending
+#define SIM_NEVER				UINT64_MAX
+//Default bandwidth of the DMA memory port in MB/s
+#define SIM_DMA_BANDWIDTH		400
+//Bursts of the DMA memory port, 16 beats of 32 bits, and the time it takes to start one in ns
+#define SIM_BURST_BYTES			64
+#define SIM_BURST_SETUP			20
+//AXI bursts never cross this boundary
+#define SIM_BURST_BOUNDARY		4096
+
+/*************************************************************
+* Type section
+*************************************************************/
+//Receives the data of a MM2S transfer routed to the VGA output
+typedef void (*simSinkHandler)(UINTPTR addr, u32 length, u64 time);
+
+/*************************************************************
+* Struct section
+*************************************************************/
+typedef struct simConfig_t {
+	u32 hasSg;				//DMA built with the scatter-gather engine
+	u32 bandwidth;			//Bandwidth of the DMA memory port in MB/s
+	u32 errorAt;			//MM2S transfer that ends with a slave error, 0 for none
+} simConfig;
+
+typedef struct simIsrStats_t {
+	u32 calls;				//Number of times the handler ran
+	u64 hostTime;			//Host time spent in the handler in ns
+	u64 maxHostTime;		//Longest run of the handler in ns
+	u64 registerAccesses;	//Register reads and writes done by the handler
+} simIsrStats;
+
+typedef struct simCounters_t {
+	u64 registerReads;		//Peripheral register reads
+	u64 registerWrites;		//Peripheral register writes
+	u64 flushCalls;			//Cache flushes of a range
+	u64 flushBytes;			//Bytes flushed by range
+	u64 fullFlushes;		//Flushes of the whole data cache
+	u64 mappingChanges;		//MMU sections whose attributes changed
+	u64 invalidateBytes;	//Bytes invalidated
+	u64 mm2sTransfers;		//Transfers (or descriptors) done by MM2S
+	u64 mm2sBytes;			//Bytes read by MM2S
+	u64 mm2sBursts;			//Bursts issued by MM2S
+	u64 mm2sCrossings;		//Transfers that crossed a SIM_BURST_BOUNDARY
+	u64 vgaTransfers;		//Transfers MM2S sent to the VGA output
+	u64 vgaBytes;			//Bytes MM2S sent to the VGA output
+	u64 vgaBursts;			//Bursts of the transfers sent to the VGA output
+	u64 vgaTime;			//Time MM2S spent on the transfers to the VGA output in ns
+	u64 s2mmBytes;			//Bytes written by S2MM
+	u64 dmaErrors;			//Errors raised by the DMA model
+	u64 spuriousInterrupts;	//Interrupts raised with no handler connected
+} simCounters;
+
+/*************************************************************
+* Variable declaration section
+*************************************************************/
+extern simConfig simCfg;
+extern volatile u64 simTime;
+extern simCounters simCount;
+extern simIsrStats simIsr[SIM_MAX_INTR];
+extern simSinkHandler simSink;
+//Display mode the VGA timing generator runs, written through its mode select
+extern volatile u32 simTimingMode;
+
+/*************************************************************
+* Function prototype section
+*************************************************************/
+//Takes the lock of the hardware models.
+void simLock(void);
+//Releases the lock of the hardware models.
+void simUnlock(void);
+//Marks the calling thread as the one running the hardware.
+void simSetHardwareThread(void);
+//Raises an interrupt in the GIC model.
+void simRaise(u32 intrId);
+//Runs the pending and enabled interrupt handlers.
+void simDispatch(void);
+//Returns the time of the next DMA event.
+u64 simDmaNextEvent(void);
+//Finishes the DMA transfers due at simTime.
+void simDmaAdvance(void);
+//Receives a character on the UART.
+int simUartReceive(u8 c);
+
+#endif /* SIMHW_H */
+
+/*************************************************************
+* End of file
+*************************************************************/
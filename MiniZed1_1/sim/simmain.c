@@ -0,0 +1,800 @@
+/**************************************************************
+ * File: simmain.c
+ * Description: Host simulator of the MiniZed VGA design. Runs
+ * the application against the DMA, GIC and UART models, drives
+ * HSync and VSync with the timing of the selected display mode
+ * and checks and measures the scanout.
+ *
+ * Author: Ahac Rafael Bela
+ * Created on: 30.04.2025
+ * Last modified: 17.05.2025
+ *************************************************************/
+
+/*************************************************************
+* Include section
+*************************************************************/
+#include "libs.h"
+#include "vga.h"
+#include "lines.h"
+#include "prefetch.h"
+#include "bench.h"
+#include "display.h"
+#include "rle.h"
+#include "kernels.h"
+#include "simhw.h"
+#include <pthread.h>
+#include <time.h>
+
+/*************************************************************
+* Macro section
+*************************************************************/
+//Length of one line of a display mode in ns
+#define LINE_TIME(m)		(DISPLAY_H_TOTAL(m) * 1000000000ULL / (m)->pixelClock)
+//Bytes the VGA output takes for one visible line of the frame on screen, it repeats no pixels
+#define LINE_BYTES			(DISPLAY_ACTIVE_WIDTH(frameTiming) * SCAN_BYTES_PER_PIXEL)
+//Bits of a line buffer pixel the VGA output uses, the top byte of XRGB8888 is not sent on
+#define SCAN_PIXEL_MASK		((SCAN_BYTES_PER_PIXEL == 2) ? 0xFFFFU : 0xFFFFFFU)
+//Longest run the kernels are compared on in words, past the vector loops of every head
+#define KERNEL_CHECK_WORDS	40
+//Default length of a run in frames
+#define SIM_FRAMES			60
+//Frames a scenario may overrun the run before it is stopped
+#define SIM_WATCHDOG_FRAMES	600
+
+/*************************************************************
+* Enum section
+*************************************************************/
+typedef enum simScenario_t {
+	SCENARIO_IDLE,		//Scanout of a black screen only
+	SCENARIO_MENU,		//Draws the menu once
+	SCENARIO_ECHO,		//Echo sub-program fed by the UART
+	SCENARIO_LINES,		//Lines sub-program until ESC arrives
+	SCENARIO_BENCH,		//Framebuffer mapping, pixel throughput and kernel benchmarks over the menu
+	SCENARIO_MODES,		//Menu drawn in every display mode in turn
+	SCENARIO_ROWS,		//Menu scrolled through the row tables below a shared band
+	SCENARIO_RLE,		//Compressed frame benchmark over the menu
+	SCENARIO_PRESENT,	//One row changed per present, checks what is copied and flushed
+	SCENARIO_KERNELS	//Vector kernels compared with the scalar ones word by word
+} simScenario;
+
+/*************************************************************
+* Struct section
+*************************************************************/
+typedef struct scanCheck_t {
+	u32 frames;				//Frames checked
+	u32 badFrames;			//Frames with a late, missing or misordered line
+	u32 excusedFrames;		//Bad frames in which the DMA model raised an error
+	u32 lateLines;			//Lines that arrived after the beam reached them
+	u32 missingLines;		//Lines that never arrived
+	u32 misorderedLines;	//Lines that arrived twice or out of order
+	u32 wrongLines;			//Lines from the line buffers whose pixels differ from their row
+	u64 blankingBytes;		//Bytes sent for the blanking interval
+	u64 minSlack;			//Shortest time between arrival and display in ns
+} scanCheck;
+
+typedef struct presentCheck_t {
+	u32 changes;			//Presents of a frame with one changed row
+	u32 rowsFlushed;		//Rows the scanout flushed after them
+	u32 mismatches;			//New draw buffers that differed from the presented frame
+} presentCheck;
+
+typedef struct kernelCheck_t {
+	u32 runs;				//Runs written by both kernels
+	u32 mismatches;			//Of them written differently by the vector kernel
+} kernelCheck;
+
+typedef struct linesCheck_t {
+	u32 pixels;				//Pixels of the lines on screen just before ESC
+	u32 pixelsOutside;		//Of them drawn with an entry outside the cycle
+	u32 cycled;				//Entries of the cycle whose color changed
+	u32 changedOutside;		//Entries outside the cycle whose color changed
+} linesCheck;
+
+/*************************************************************
+* Global variable section
+*************************************************************/
+static XAxiDma AxiDma;
+static INTC Intc;
+static XUartPs UartPs;
+
+selectorWText selectorWText1;
+selectorWText selectorWText2;
+selectorWText selectorWText3;
+selectorWText selectorWText4;
+
+u32 discovered = 0;
+
+static simScenario scenario = SCENARIO_IDLE;
+static u32 framesToRun = SIM_FRAMES;
+static const char *keys = NULL;
+static u32 keyInterval = 0;
+static volatile u32 keysSent = 0;
+static volatile u32 framesDone = 0;
+static volatile u32 stopHardware = 0;
+
+static benchResult benchResults[BENCH_MAPPINGS];
+static rleBenchResult rleResult;
+static spanBenchResult spanResult;
+static kernelBenchResult kernelResults[BENCH_KERNEL_PATHS];
+
+static scanCheck check = {0, 0, 0, 0, 0, 0, 0, 0, SIM_NEVER};
+static presentCheck presentChecked = {0, 0, 0};
+static linesCheck linesChecked = {0, 0, 0, 0};
+static kernelCheck kernelChecked = {0, 0};
+#if FB_INDEXED
+//Palette entries seen with a color other than their own during the lines sub-program
+static u8 entryChanged[PALETTE_SIZE];
+#endif
+static pixel *const *frameRows = NULL;
+static const rleFrame *frameRle = NULL;
+static const displayMode *frameTiming = NULL;
+//Display mode the frame on screen was drawn in
+static const displayMode *frameMode = NULL;
+//Copy of the screen the compressed frame was encoded from, rows FB_PITCH apart
+static pixel rleSourceRows[FB_MAX_SIZE / sizeof(pixel)];
+static u64 frameStart = 0;
+static s32 expectedLine = 0;
+static u32 frameErrors = 0;
+static u64 dmaErrorsAtFrameStart = 0;
+
+/*************************************************************
+* Function definition section
+*************************************************************/
+
+/*************************************************************
+* frameSource returns the row a visible line of the frame on
+* 			screen is sent from, a row of runs if it is compressed.
+*************************************************************/
+static UINTPTR frameSource(s32 line) {
+	return frameRle ? (UINTPTR) frameRle->rows[line / frameMode->scale] : (UINTPTR) frameRows[line];
+}
+
+/*************************************************************
+* lineArrived checks a whole line that arrived against the row
+* 			table of the frame on screen.
+*
+* @param	source is the row the line was sent from.
+* @param	time is the time its last byte arrived.
+*
+* @note		Visible line l of a frame is shown DISPLAY_V_BLANK + l + 1
+* 			lines after VSync, one line after the HSync that
+* 			requests it. A row shown on several lines, repeated in
+* 			a pixel-doubled mode or shared, has to arrive for each.
+* 			The row is looked for at the expected line, then after
+* 			it (the lines in between are missing), then before it
+* 			(misordered). A row of no line is blanking.
+*************************************************************/
+static void lineArrived(UINTPTR source, u64 time) {
+	s32 lines = DISPLAY_ACTIVE_HEIGHT(frameTiming);
+	s32 line = expectedLine;
+
+	while(line < lines && frameSource(line) != source) line++;
+	if(line == lines) {
+		for(line = expectedLine - 1; line >= 0 && frameSource(line) != source; line--);
+	}
+	if(line < 0) {
+		check.blankingBytes += LINE_BYTES;
+		return;
+	}
+
+	if(line < expectedLine) {
+		check.misorderedLines++;
+		frameErrors++;
+	} else if(line > expectedLine) {
+		check.missingLines += line - expectedLine;
+		frameErrors++;
+	}
+	u64 deadline = frameStart + (DISPLAY_V_BLANK(frameTiming) + line + 1) * LINE_TIME(frameTiming);
+	if(time > deadline) {
+		check.lateLines++;
+		frameErrors++;
+	} else if(deadline - time < check.minSlack) check.minSlack = deadline - time;
+	expectedLine = line + 1;
+}
+
+/*************************************************************
+* checkLinePixels checks the pixels of a line buffer the DMA sent
+* 			against the row they were expanded from.
+*
+* @param	slot is the line buffer.
+* @param	offset is the byte of the line buffer the data starts at.
+* @param	length is the number of bytes sent.
+*
+* @note		The expected pixels are worked out here, without the
+* 			expansion, decoding and pixel repeat of the scanout. A
+* 			row of runs is checked against the row of the screen
+* 			it was encoded from.
+*************************************************************/
+static void checkLinePixels(u32 slot, u32 offset, u32 length) {
+	const pixel *row = (const pixel *) scanLineSources[slot];
+	const u8 *line = (const u8 *) scanLines[slot];
+
+	if(frameRle) {
+		s32 y = 0;
+
+		while(y < (s32) frameRle->height && (const void *) frameRle->rows[y] != (const void *) row) y++;
+		if(y == (s32) frameRle->height) {
+			check.wrongLines++;
+			return;
+		}
+		row = FB_ROW(rleSourceRows, y);
+	}
+	for(u32 x = offset / SCAN_BYTES_PER_PIXEL; x < (offset + length) / SCAN_BYTES_PER_PIXEL; x++) {
+		u32 fbX = x / frameMode->scale;
+		u32 sent = (SCAN_BYTES_PER_PIXEL == 2) ? ((const u16 *) line)[x] : ((const u32 *) line)[x];
+#if FB_INDEXED
+		u32 expected = palette[((const u8 *) row)[fbX / PIXELS_PER_BYTE] >> (fbX % PIXELS_PER_BYTE * FB_BITS_PER_PIXEL) & PALETTE_INDEX_MASK];
+#else
+		u32 expected = row[fbX];
+#endif
+
+		if((sent ^ expected) & SCAN_PIXEL_MASK) {
+			check.wrongLines++;
+			return;
+		}
+	}
+}
+
+/*************************************************************
+* scanoutSink receives the lines MM2S sends to the VGA output
+* 			and checks them against the frame on screen.
+*
+* @param	addr is the address the data was read from.
+* @param	length is the number of bytes sent.
+* @param	time is the time the transfer finished.
+*
+* @return	None.
+*
+* @note		A line counts once its last byte arrived, it may come
+* 			in parts and one transfer may hold several lines. Lines
+* 			of indexed framebuffers, pixel-doubled modes and
+* 			compressed frames come from the line buffers and are
+* 			known by the row they were expanded from, their pixels
+* 			are checked against it.
+*************************************************************/
+static void scanoutSink(UINTPTR addr, u32 length, u64 time) {
+	//Line being assembled, from where its first byte was read
+	static UINTPTR lineStart = 0;
+	static u32 lineBytes = 0;
+
+	if(!frameRows) {
+		check.blankingBytes += length;
+		return;
+	}
+	if(FB_INDEXED || frameRle || frameMode->scale > 1) {
+		u32 slot = (addr - (UINTPTR) scanLines) / sizeof(scanLines[0]);
+
+		if(addr < (UINTPTR) scanLines || slot >= SCAN_LINE_BUFFERS || !scanLineSources[slot]) {
+			check.blankingBytes += length;
+			lineBytes = 0;
+			return;
+		}
+		checkLinePixels(slot, addr - (UINTPTR) scanLines[slot], length);
+		addr = (UINTPTR) scanLineSources[slot] + (addr - (UINTPTR) scanLines[slot]);
+	}
+	while(length) {
+		if(!lineBytes || addr != lineStart + lineBytes) {
+			lineStart = addr;
+			lineBytes = 0;
+		}
+		u32 part = (length < LINE_BYTES - lineBytes) ? length : LINE_BYTES - lineBytes;
+
+		addr += part;
+		length -= part;
+		lineBytes += part;
+		if(lineBytes < (u32) LINE_BYTES) continue;
+
+		lineArrived(lineStart, time);
+		lineBytes = 0;
+	}
+}
+
+#if FB_INDEXED
+/*************************************************************
+* checkLinesPalette notes the palette entries the lines cycle
+* 			changed, called at every VSync.
+*************************************************************/
+static void checkLinesPalette(void) {
+	for(u32 i = 0; i < PALETTE_SIZE; i++) {
+		if(palette[i] != getPaletteEntry(i)) entryChanged[i] = 1;
+	}
+}
+
+/*************************************************************
+* checkLinesPixels checks that the lines on screen are drawn
+* 			with the cycled entries only, just before ESC ends the
+* 			lines sub-program.
+*************************************************************/
+static void checkLinesPixels(void) {
+	for(s32 y = LINES_TOP; y < SCREEN_HEIGHT; y++) {
+		const u8 *row = (const u8 *) FB_ROW(scanoutArray, y);
+
+		for(s32 x = 0; x < SCREEN_WIDTH; x++) {
+			u32 index = row[x / PIXELS_PER_BYTE] >> (x % PIXELS_PER_BYTE * FB_BITS_PER_PIXEL) & PALETTE_INDEX_MASK;
+
+			//Black is the background
+			if(!index) continue;
+			linesChecked.pixels++;
+			if(index < LINES_CYCLE_FIRST || index >= LINES_CYCLE_FIRST + LINES_CYCLE_COUNT) linesChecked.pixelsOutside++;
+		}
+	}
+	for(u32 i = 0; i < PALETTE_SIZE; i++) {
+		if(!entryChanged[i]) continue;
+		if(i < LINES_CYCLE_FIRST || i >= LINES_CYCLE_FIRST + LINES_CYCLE_COUNT) linesChecked.changedOutside++;
+		else linesChecked.cycled++;
+	}
+}
+#endif
+
+/*************************************************************
+* frameEnd finishes the check of a frame at VSync.
+*************************************************************/
+static void frameEnd(void) {
+#if FB_INDEXED
+	if(scenario == SCENARIO_LINES) checkLinesPalette();
+#endif
+	if(!frameRows) return;
+	if(expectedLine < (s32) DISPLAY_ACTIVE_HEIGHT(frameTiming)) {
+		check.missingLines += DISPLAY_ACTIVE_HEIGHT(frameTiming) - expectedLine;
+		frameErrors++;
+	}
+	check.frames++;
+	if(frameErrors) {
+		check.badFrames++;
+		//A frame hit by an injected DMA error is allowed to lose lines
+		if(simCount.dmaErrors != dmaErrorsAtFrameStart) check.excusedFrames++;
+	}
+}
+
+/*************************************************************
+* hardwareMain advances simulated time line by line, raises HSync,
+* 			VSync and UART interrupts, finishes DMA transfers
+* 			and runs the handlers.
+*
+* @param	arg is unused.
+*
+* @return	NULL.
+*
+* @note		Time only advances while the main context has no
+* 			interrupt masked, see XScuGic_Disable. A write to the
+* 			mode select of the timing generator restarts the frame,
+* 			the interrupted one is not checked. Without the mode
+* 			select a new display mode keeps the timing, the frame
+* 			it interrupted is not checked either.
+*************************************************************/
+static void *hardwareMain(void *arg) {
+	const displayMode *timing = NULL;
+	u64 nextLine = simTime;
+	u32 line = 0;
+
+	(void) arg;
+	simSetHardwareThread();
+	while(!stopHardware) {
+		simLock();
+		simDispatch();
+
+		if(timing != &displayModes[simTimingMode]) {
+			timing = &displayModes[simTimingMode];
+			frameRows = NULL;
+			line = 0;
+		}
+		if(frameRows && frameMode != currentMode) frameRows = NULL;
+
+		u64 dmaAt = simDmaNextEvent();
+		if(dmaAt <= nextLine) {
+			simTime = dmaAt;
+			simDmaAdvance();
+			simDispatch();
+		} else {
+			simTime = nextLine;
+			if(line == 0) {
+				frameEnd();
+				//Keys arrive one per keyInterval frames
+				if(keys && keys[keysSent] && framesDone && framesDone % keyInterval == 0) {
+#if FB_INDEXED
+					if(scenario == SCENARIO_LINES && keys[keysSent] == 0x1B && !linesChecked.pixels) checkLinesPixels();
+#endif
+					if(simUartReceive(keys[keysSent])) keysSent++;
+				}
+				simRaise(VSYNC_INTR_ID);
+			}
+			simRaise(HSYNC_INTR_ID);
+			simDispatch();
+			if(line == 0) {
+				//The frame on screen is known once VSync flipped the buffers
+				frameRows = scanoutLineRows;
+				frameRle = scanoutRle;
+				frameTiming = timing;
+				frameMode = currentMode;
+				frameStart = simTime;
+				expectedLine = 0;
+				frameErrors = 0;
+				dmaErrorsAtFrameStart = simCount.dmaErrors;
+				framesDone++;
+			}
+			line = (line + 1) % DISPLAY_V_TOTAL(timing);
+			nextLine += LINE_TIME(timing);
+		}
+		simUnlock();
+
+		if(framesDone > framesToRun + SIM_WATCHDOG_FRAMES) {
+			printf("Scenario did not finish, stopped after %u frames\n", framesDone);
+			exit(2);
+		}
+	}
+	return NULL;
+}
+
+/*************************************************************
+* waitFrames waits until the hardware showed a number of frames.
+*************************************************************/
+static void waitFrames(u32 frames) {
+	u32 until = framesDone + frames;
+
+	while(framesDone < until) {
+		struct timespec wait = {0, 1000000};
+		nanosleep(&wait, NULL);
+	}
+}
+
+/*************************************************************
+* scrollMenu scrolls the menu one row per frame below a band of
+* 			lines sharing one row, through the row tables only.
+*************************************************************/
+static void scrollMenu(void) {
+	static pixel band[FB_MAX_PITCH / sizeof(pixel)] __attribute__((aligned(DMA_BURST_BOUNDARY)));
+	u32 bandLines = SCAN_HEIGHT / 8;
+
+	//One row outside the framebuffers, flushed by its writer
+	memset(band, 0x55, sizeof(band));
+	Xil_DCacheFlushRange((INTPTR) band, sizeof(band));
+	for(u32 line = 0; line < bandLines; line++) setLineRow(line, band);
+
+	while(framesDone < framesToRun) {
+		scrollLineRows(bandLines, SCAN_HEIGHT - bandLines, SCREEN_SCALE);
+		present();
+	}
+}
+
+/*************************************************************
+* presentRows changes one row per frame and checks that present
+* 			hands the new draw buffer a copy of the presented
+* 			frame and that the change is flushed once from every
+* 			framebuffer, not the whole screen.
+*************************************************************/
+static void presentRows(void) {
+	//Every buffer takes the drawn menu and is scanned out once
+	for(u32 i = 0; i < FB_COUNT; i++) present();
+	waitFrames(FB_COUNT + 1);
+
+	while(framesDone < framesToRun) {
+		u32 row = (presentChecked.changes * 7) % SCREEN_HEIGHT;
+		u32 flushed = rowFlushes.flushed;
+
+		hspan(&screenSurface, row, 0, SCREEN_WIDTH - 1, (presentChecked.changes & 1) ? white : blue);
+		//The change reaches every buffer, the last present draws into the first one again
+		for(u32 i = 0; i < FB_COUNT; i++) {
+			pixel *shown = vgaArray;
+
+			present();
+			if(memcmp(vgaArray, shown, FB_SIZE)) presentChecked.mismatches++;
+		}
+		waitFrames(FB_COUNT + 1);
+		presentChecked.changes++;
+		presentChecked.rowsFlushed += rowFlushes.flushed - flushed;
+	}
+}
+
+/*************************************************************
+* runKernel writes a run with fillWords, copyWords or expandWords
+* 			on the kernels of a path.
+*************************************************************/
+static void runKernel(kernelPath kernelsPath, u32 kernel, u32 *dst, const u32 *src, u32 count, u32 bits) {
+	setKernelPath(kernelsPath);
+	if(kernel == 0) fillWords(dst, 0x5A5AC3C3, count);
+	else if(kernel == 1) copyWords(dst, src, count);
+	else expandWords(dst, bits, count, 0x00FF00FF, 0x11223344);
+}
+
+/*************************************************************
+* compareKernels runs the scalar and the vector kernels on the
+* 			same runs and compares what they wrote, the words
+* 			around the run included. The runs start at every
+* 			word of a vector, copies read from every word of one,
+* 			and are up to KERNEL_CHECK_WORDS long, so short tails,
+* 			runs just below and above KERNEL_VECTOR_MIN and the
+* 			lanes of every bit of the expand masks are covered.
+*************************************************************/
+static void compareKernels(void) {
+	static const u32 masks[] = {0x00000000, 0xFFFFFFFF, 0x80000001, 0xA5C3F00F, 0x12345678, 0x0F0F0F0F, 0x00010000};
+	static u32 src[KERNEL_CHECK_WORDS + 4] __attribute__((aligned(KERNEL_VECTOR_BYTES)));
+	static u32 out[2][KERNEL_CHECK_WORDS + 8] __attribute__((aligned(KERNEL_VECTOR_BYTES)));
+	kernelPath saved = getKernelPath();
+
+	if(setKernelPath(KERNELS_VECTOR) != XST_SUCCESS) return;
+	for(u32 i = 0; i < KERNEL_CHECK_WORDS + 4; i++) src[i] = 0x9E3779B9 * (i + 1);
+
+	for(u32 kernel = 0; kernel < 3; kernel++) {
+		//Only copies read a source, only expands take a mask and at most 32 words
+		u32 srcHeads = (kernel == 1) ? 4 : 1;
+		u32 maskCount = (kernel == 2) ? sizeof(masks) / sizeof(masks[0]) : 1;
+		u32 maxCount = (kernel == 2) ? 32 : KERNEL_CHECK_WORDS;
+
+		for(u32 head = 0; head < 4; head++) {
+			for(u32 srcHead = 0; srcHead < srcHeads; srcHead++) {
+				for(u32 count = 0; count <= maxCount; count++) {
+					for(u32 m = 0; m < maskCount; m++) {
+						memset(out, 0xEE, sizeof(out));
+						runKernel(KERNELS_SCALAR, kernel, &out[0][head], &src[srcHead], count, masks[m]);
+						runKernel(KERNELS_VECTOR, kernel, &out[1][head], &src[srcHead], count, masks[m]);
+						kernelChecked.runs++;
+						if(memcmp(out[0], out[1], sizeof(out[0]))) kernelChecked.mismatches++;
+					}
+				}
+			}
+		}
+	}
+	setKernelPath(saved);
+}
+
+/*************************************************************
+* runScenario runs the application code of a scenario.
+*************************************************************/
+static void runScenario(void) {
+	//First call to the receive function of UART, as main does
+	XUartPs_Recv(ctrls->UartPs, (u8 *) &caughtChar, 1);
+	caughtChar = '\0';
+
+	switch(scenario) {
+	case SCENARIO_IDLE:
+		break;
+	case SCENARIO_MENU:
+		drawStage();
+		break;
+	case SCENARIO_ECHO:
+		drawStage();
+		enterEcho();
+		break;
+	case SCENARIO_LINES:
+		drawStage();
+		enterLines();
+		break;
+	case SCENARIO_BENCH:
+		drawStage();
+		benchmarkMapping(benchResults);
+		benchmarkSpans(&spanResult);
+		benchmarkKernels(kernelResults);
+		break;
+	case SCENARIO_MODES: {
+		displayModeId first = getDisplayMode();
+
+		drawStage();
+		//Through every mode and back to the first one
+		for(u32 i = 1; i <= DISPLAY_MODES; i++) {
+			displayModeId next = (first + i) % DISPLAY_MODES;
+
+			waitFrames(framesToRun / (DISPLAY_MODES + 1));
+			//The SG engine can not repeat pixels, it skips the pixel-doubled modes
+			if(setDisplayMode(next) != XST_SUCCESS) {
+				if(displayModes[next].scale == 1 || !simCfg.hasSg) exit(XST_FAILURE);
+				continue;
+			}
+			initSelectors();
+			drawStage();
+		}
+		break;
+	}
+	case SCENARIO_ROWS:
+		drawStage();
+		scrollMenu();
+		break;
+	case SCENARIO_RLE:
+		drawStage();
+		//The draw buffer holds the screen the benchmark compresses
+		waitFill();
+		for(s32 y = 0; y < SCREEN_HEIGHT; y++) memcpy(FB_ROW(rleSourceRows, y), SURFACE_ROW(&screenSurface, y), FB_LINE_BYTES);
+		if(benchmarkRle(&rleResult) != XST_SUCCESS) exit(XST_FAILURE);
+		break;
+	case SCENARIO_PRESENT:
+		drawStage();
+		presentRows();
+		break;
+	case SCENARIO_KERNELS:
+		compareKernels();
+		break;
+	}
+}
+
+/*************************************************************
+* printIsr prints the cost of one interrupt handler.
+*************************************************************/
+static void printIsr(const char *name, u32 intrId, u32 frames) {
+	simIsrStats *isr = &simIsr[intrId];
+
+	if(!isr->calls) {
+		printf("  %-6s %10u\n", name, 0);
+		return;
+	}
+	printf("  %-6s %10u %10.1f %10llu %10llu %10.1f\n", name, isr->calls, (double) isr->calls / frames,
+			(unsigned long long) (isr->hostTime / isr->calls), (unsigned long long) isr->maxHostTime,
+			(double) isr->registerAccesses / isr->calls);
+}
+
+/*************************************************************
+* printReport prints the scanout check and the measurements.
+*************************************************************/
+static void printReport(void) {
+	u32 frames = check.frames ? check.frames : 1;
+	dmaErrors errors;
+
+	dmaGetErrors(&errors);
+	printf("\nSimulated %u frames (%.1f ms) of %s, %s mode, prefetch depth %u, %u MB/s\n",
+			check.frames, simTime / 1e6, currentMode->name, simCfg.hasSg ? "SG" : "simple", scanoutPrefetch.depth,
+			simCfg.bandwidth);
+	printf("Framebuffers: %u bits per pixel%s, %u KiB each\n", FB_BITS_PER_PIXEL, FB_INDEXED ? " indexed" : "",
+			FB_SIZE / 1024);
+	printf("Scanout: %u bad frames (%u with DMA errors), %u late, %u missing, %u misordered lines\n",
+			check.badFrames, check.excusedFrames, check.lateLines, check.missingLines, check.misorderedLines);
+	if(check.wrongLines) printf("  %u lines sent with pixels other than their row\n", check.wrongLines);
+	if(check.minSlack != SIM_NEVER) printf("  closest line arrived %llu ns before the beam\n", (unsigned long long) check.minSlack);
+	printf("  %.1f blanking lines per frame\n", (double) check.blankingBytes / LINE_BYTES / frames);
+
+	printf("Interrupts:     calls  per frame  avg ns     max ns     registers\n");
+	printIsr("HSync", HSYNC_INTR_ID, frames);
+	printIsr("VSync", VSYNC_INTR_ID, frames);
+	printIsr("MM2S", MM2S_INTR_ID, frames);
+	printIsr("S2MM", S2MM_INTR_ID, frames);
+	printIsr("UART", UART_INTR_ID, frames);
+
+	printf("DMA: %llu transfers, %.1f KiB to VGA and %.1f KiB copied per frame\n",
+			(unsigned long long) simCount.mm2sTransfers, simCount.vgaBytes / 1024.0 / frames,
+			simCount.s2mmBytes / 1024.0 / frames);
+	printf("  %u dropped lines, %u prefetch underruns, %u errors, %u resets\n", mm2sStats.dropped,
+			scanoutPrefetch.underruns, (u32) simCount.dmaErrors, errors.resets);
+	if(simCount.vgaTransfers) {
+		double rate = (double) simCount.vgaBytes * 1000 / simCount.vgaTime;
+		printf("Bandwidth: pitch %u bytes, %.0f bytes and %.1f bursts per transfer, %llu transfers across 4 KB\n",
+				FB_PITCH, (double) simCount.vgaBytes / simCount.vgaTransfers,
+				(double) simCount.vgaBursts / simCount.vgaTransfers, (unsigned long long) simCount.mm2sCrossings);
+		printf("  %.0f MB/s achieved, %.0f bytes per line time for %u needed", rate, rate * LINE_TIME(currentMode) / 1000, LINE_BYTES);
+		//Only simple mode transfers are timed by the driver
+		if(mm2sStats.totalLatency) {
+			printf(", driver measured %.0f MB/s", (double) mm2sStats.bytes * COUNTS_PER_SECOND / mm2sStats.totalLatency / 1e6);
+		}
+		printf("\n");
+	}
+	printf("Registers: %.1f reads and %.1f writes per frame\n", (double) simCount.registerReads / frames,
+			(double) simCount.registerWrites / frames);
+	printf("Cache: %.1f KiB flushed, %.1f KiB invalidated per frame, %llu full flushes, %llu sections remapped\n",
+			simCount.flushBytes / 1024.0 / frames, simCount.invalidateBytes / 1024.0 / frames,
+			(unsigned long long) simCount.fullFlushes, (unsigned long long) simCount.mappingChanges);
+	printf("  %.1f rows flushed and %.1f skipped per frame, %.0f flushes skipped per second\n",
+			(double) rowFlushes.flushed / frames, (double) rowFlushes.skipped / frames,
+			simTime ? rowFlushes.skipped * 1e9 / simTime : 0.0);
+	if(FB_INDEXED && scenario == SCENARIO_LINES) {
+		printf("Lines: %u pixels, %u outside the cycle of entries %u to %u, %u of its entries cycled, %u entries changed outside it\n",
+				linesChecked.pixels, linesChecked.pixelsOutside, LINES_CYCLE_FIRST, LINES_CYCLE_FIRST + LINES_CYCLE_COUNT - 1,
+				linesChecked.cycled, linesChecked.changedOutside);
+	}
+	if(scenario == SCENARIO_KERNELS) {
+		if(!KERNELS_HAVE_VECTOR) printf("Kernels: no vector kernels built\n");
+		else printf("Kernels: %u runs compared, %u written differently by the vector kernels\n",
+				kernelChecked.runs, kernelChecked.mismatches);
+	}
+	if(scenario == SCENARIO_PRESENT) {
+		printf("Present: %u one-row changes, %.1f rows flushed per change for %u expected, %u copies differing\n",
+				presentChecked.changes, presentChecked.changes ? (double) presentChecked.rowsFlushed / presentChecked.changes : 0.0,
+				FB_INDEXED ? 0 : FB_COUNT, presentChecked.mismatches);
+	}
+}
+
+/*************************************************************
+* usage prints the command line options.
+*************************************************************/
+static void usage(const char *name) {
+	printf("Usage: %s [options]\n", name);
+	printf("  -s idle|menu|echo|lines|bench|modes|rows|rle|present|kernels  scenario to run (idle)\n");
+	printf("  -m WxH                   display mode on startup (%s)\n", displayModes[DISPLAY_MODE].name);
+	printf("  -f frames                frames to simulate (%u)\n", SIM_FRAMES);
+	printf("  -g                       DMA with the scatter-gather engine\n");
+	printf("  -d depth                 scanout prefetch depth (%u)\n", PREFETCH_DEPTH);
+	printf("  -b MB/s                  DMA bandwidth (%u)\n", SIM_DMA_BANDWIDTH);
+	printf("  -e n                     n-th MM2S transfer fails with a slave error\n");
+	printf("  -k keys                  keys typed on the UART during the run\n");
+	exit(2);
+}
+
+/*************************************************************
+* Main function section
+*************************************************************/
+int main(int argc, char **argv) {
+	u32 depth = PREFETCH_DEPTH;
+	s32 mode = DISPLAY_MODE;
+	pthread_t hardware;
+
+	for(int i = 1; i < argc; i++) {
+		const char *arg = argv[i];
+		const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+		if(!strcmp(arg, "-g")) simCfg.hasSg = 1;
+		else if(!value) usage(argv[0]);
+		else {
+			i++;
+			if(!strcmp(arg, "-s")) {
+				if(!strcmp(value, "idle")) scenario = SCENARIO_IDLE;
+				else if(!strcmp(value, "menu")) scenario = SCENARIO_MENU;
+				else if(!strcmp(value, "echo")) scenario = SCENARIO_ECHO;
+				else if(!strcmp(value, "lines")) scenario = SCENARIO_LINES;
+				else if(!strcmp(value, "bench")) scenario = SCENARIO_BENCH;
+				else if(!strcmp(value, "modes")) scenario = SCENARIO_MODES;
+				else if(!strcmp(value, "rows")) scenario = SCENARIO_ROWS;
+				else if(!strcmp(value, "rle")) scenario = SCENARIO_RLE;
+				else if(!strcmp(value, "present")) scenario = SCENARIO_PRESENT;
+				else if(!strcmp(value, "kernels")) scenario = SCENARIO_KERNELS;
+				else usage(argv[0]);
+			}
+			else if(!strcmp(arg, "-m")) {
+				for(mode = DISPLAY_MODES - 1; mode >= 0; mode--) {
+					if(!strncmp(displayModes[mode].name, value, strlen(value))) break;
+				}
+				if(mode < 0) usage(argv[0]);
+			}
+			else if(!strcmp(arg, "-f")) framesToRun = strtoul(value, NULL, 0);
+			else if(!strcmp(arg, "-d")) depth = strtoul(value, NULL, 0);
+			else if(!strcmp(arg, "-b")) simCfg.bandwidth = strtoul(value, NULL, 0);
+			else if(!strcmp(arg, "-e")) simCfg.errorAt = strtoul(value, NULL, 0);
+			else if(!strcmp(arg, "-k")) keys = value;
+			else usage(argv[0]);
+		}
+	}
+	if(!framesToRun || !simCfg.bandwidth) usage(argv[0]);
+	//Sub-programs need a way out
+	if(!keys && scenario == SCENARIO_ECHO) keys = "Hello DMA\r\x1b";
+	if(!keys && scenario == SCENARIO_LINES) keys = "\x1b";
+	if(keys) keyInterval = framesToRun / (strlen(keys) + 1) ? framesToRun / (strlen(keys) + 1) : 1;
+
+	ctrls = &(controllers){&AxiDma, NULL, &Intc, NULL, &UartPs, NULL};
+	//The timing generator starts with the timing of the boot mode
+	simTimingMode = DISPLAY_MODE;
+	if(initPlatform(ctrls) != XST_SUCCESS) return XST_FAILURE;
+	if(setPrefetchDepth(depth) != XST_SUCCESS) usage(argv[0]);
+	if(setDisplayMode(mode) != XST_SUCCESS) usage(argv[0]);
+	Xil_DCacheFlushRange((INTPTR) vgaBuffers, FB_COUNT*FB_MAX_SIZE);
+	enableInterrupts(ctrls);
+
+	initSelectors();
+
+	//Measure the steady state only
+	memset(&simCount, 0, sizeof(simCount));
+	memset(simIsr, 0, sizeof(simIsr));
+	simSink = scanoutSink;
+	pthread_create(&hardware, NULL, hardwareMain, NULL);
+
+	runScenario();
+	while(framesDone <= framesToRun || (keys && keys[keysSent])) {
+		struct timespec wait = {0, 1000000};
+		nanosleep(&wait, NULL);
+	}
+	stopHardware = 1;
+	pthread_join(hardware, NULL);
+
+	printReport();
+	//With indexed framebuffers every line is drawn with a cycled entry and the cycle changes every entry of it only,
+	//a single entry does not cycle
+	if(FB_INDEXED && scenario == SCENARIO_LINES && (!linesChecked.pixels || linesChecked.pixelsOutside ||
+			linesChecked.changedOutside || linesChecked.cycled != (LINES_CYCLE_COUNT > 1 ? LINES_CYCLE_COUNT : 0))) {
+		return XST_FAILURE;
+	}
+	//A one-row change is flushed once from each buffer, indexed rows are read by the CPU and never flushed
+	if(presentChecked.mismatches || presentChecked.rowsFlushed != (FB_INDEXED ? 0 : presentChecked.changes * FB_COUNT)) return XST_FAILURE;
+	//The vector kernels write the same words as the scalar ones
+	if(kernelChecked.mismatches) return XST_FAILURE;
+	//Lines from the line buffers show their rows exactly
+	if(check.wrongLines) return XST_FAILURE;
+	//Only frames hit by an injected error may be damaged
+	return (check.badFrames != check.excusedFrames) ? XST_FAILURE : XST_SUCCESS;
+}
+
+/*************************************************************
+* End of file
+*************************************************************/
@@ -4,7 +4,7 @@
  *
  * Author: Ahac Rafael Bela
  * Created on: 08.04.2025
- * Last modified: 14.04.2025
+ * Last modified: 08.05.2025
  *************************************************************/
 
 /*************************************************************
@@ -22,10 +22,27 @@ snakeFood foodStack[4];
 static int foodCount = 0;
 point snakeGrid[35*35];
 
+//The layout is drawn divided by this, 2 on a screen holding only half of it
+static int layoutScale = 1;
+
 /*************************************************************
 * Function prototype section
 *************************************************************/
 
+/*************************************************************
+* toScreen converts a point of the layout to the screen.
+*
+* @param	pos is the point in the SNAKE_SCREEN_WIDTH x
+* 			SNAKE_SCREEN_HEIGHT layout.
+*
+* @return	The point on the screen.
+*
+* @note		None.
+*************************************************************/
+static point toScreen(point pos) {
+	return (point) {pos.x / layoutScale, pos.y / layoutScale};
+}
+
 /*************************************************************
 * initializeGrid initializes a 2D array with all possible
 * 			locations of the snake and food.
@@ -88,16 +105,16 @@ void drawInstructions(colors textColor) {
 	point dBoxBR = {460, 340};
 
 	//Box containers for letters
-	drawBox(wBoxTL, wBoxBR, textColor);
-	drawBox(sBoxTL, sBoxBR, textColor);
-	drawBox(aBoxTL, aBoxBR, textColor);
-	drawBox(dBoxTL, dBoxBR, textColor);
+	drawBox(&screenSurface, toScreen(wBoxTL), toScreen(wBoxBR), textColor);
+	drawBox(&screenSurface, toScreen(sBoxTL), toScreen(sBoxBR), textColor);
+	drawBox(&screenSurface, toScreen(aBoxTL), toScreen(aBoxBR), textColor);
+	drawBox(&screenSurface, toScreen(dBoxTL), toScreen(dBoxBR), textColor);
 
 	//Letters
-	drawText("w", (point) {wBoxTL.x+13, wBoxTL.y+4}, 2, textColor, black);
-	drawText("s", (point) {sBoxTL.x+13, sBoxTL.y+4}, 2, textColor, black);
-	drawText("a", (point) {aBoxTL.x+13, aBoxTL.y+4}, 2, textColor, black);
-	drawText("d", (point) {dBoxTL.x+13, dBoxTL.y+4}, 2, textColor, black);
+	drawText(&screenSurface, "w", toScreen((point) {wBoxTL.x+13, wBoxTL.y+4}), 2 / layoutScale, textColor, black);
+	drawText(&screenSurface, "s", toScreen((point) {sBoxTL.x+13, sBoxTL.y+4}), 2 / layoutScale, textColor, black);
+	drawText(&screenSurface, "a", toScreen((point) {aBoxTL.x+13, aBoxTL.y+4}), 2 / layoutScale, textColor, black);
+	drawText(&screenSurface, "d", toScreen((point) {dBoxTL.x+13, dBoxTL.y+4}), 2 / layoutScale, textColor, black);
 }
 
 /*************************************************************
@@ -127,7 +144,7 @@ void clearInstructions(void) {
 void drawBody(point pos, colors color) {
 	point posTL = {pos.x+6, pos.y+6};
 	point posBR = {pos.x+10, pos.y+10};
-	drawBoxFull(posTL, posBR, color);
+	drawBoxFull(&screenSurface, toScreen(posTL), toScreen(posBR), color);
 }
 
 /*************************************************************
@@ -143,7 +160,7 @@ void drawBody(point pos, colors color) {
 void drawHead(point pos, colors color) {
 	point posTL = {pos.x+2, pos.y+2};
 	point posBR = {pos.x+14, pos.y+14};
-	drawBoxFull(posTL, posBR, color);
+	drawBoxFull(&screenSurface, toScreen(posTL), toScreen(posBR), color);
 }
 
 /*************************************************************
@@ -319,7 +336,8 @@ int checkBoundaries(void) {
 *************************************************************/
 void gameOver(void) {
 	drawExtras();
-	drawText("Game Over!", (point) {320, 284}, 2, white, red);
+	drawText(&screenSurface, "Game Over!", toScreen((point) {320, 284}), 2 / layoutScale, white, red);
+	present();
 }
 
 /*************************************************************
@@ -343,7 +361,7 @@ void spawnFood(void) {
 	}
 
 	if(foodCount == 0) {
-		drawBoxFull((point) {Food.pos.x+7, Food.pos.y+7}, (point) {Food.pos.x+9, Food.pos.y+9}, red);
+		drawBoxFull(&screenSurface, toScreen((point) {Food.pos.x+7, Food.pos.y+7}), toScreen((point) {Food.pos.x+9, Food.pos.y+9}), red);
 		foodStack[foodCount].pos = Food.pos;
 		foodStack[foodCount].consumed = 0;
 		foodCount++;
@@ -366,7 +384,9 @@ void spawnFood(void) {
 *
 * @return	None.
 *
-* @note		None.
+* @note		The field is drawn at half size on a screen smaller
+* 			than SNAKE_SCREEN_WIDTH x SNAKE_SCREEN_HEIGHT. The caller
+* 			draws the menu again after.
 *************************************************************/
 void enterSnake(void) {
 	//Draw playing square
@@ -375,12 +395,16 @@ void enterSnake(void) {
 	point leftBot = {119, 597};
 	point rightBot = {681, 597};
 
-	drawStraight(leftTop, rightTop, red);
-	drawStraight(leftTop, leftBot, red);
-	drawStraight(leftBot, rightBot, red);
-	drawStraight(rightTop, rightBot, red);
+	//The game logic keeps the layout coordinates, only drawing is scaled
+	layoutScale = (SCREEN_WIDTH < SNAKE_SCREEN_WIDTH || SCREEN_HEIGHT < SNAKE_SCREEN_HEIGHT) ? 2 : 1;
+
+	drawStraight(&screenSurface, toScreen(leftTop), toScreen(rightTop), red);
+	drawStraight(&screenSurface, toScreen(leftTop), toScreen(leftBot), red);
+	drawStraight(&screenSurface, toScreen(leftBot), toScreen(rightBot), red);
+	drawStraight(&screenSurface, toScreen(rightTop), toScreen(rightBot), red);
 
 	drawInstructions(white);
+	present();
 	sleep(2);
 	clearInstructions();
 
@@ -413,6 +437,7 @@ void enterSnake(void) {
 
 		//Draw the snake
 		drawSnake();
+		present();
 
 		//Add delay between snake's movements
 		usleep(125000);
@@ -431,8 +456,6 @@ void enterSnake(void) {
 		updateSnake();
 
 	} while (caughtChar != 0x1B);
-	clearVGA();
-	drawStage();
 }
 
 /*************************************************************
@@ -4,7 +4,7 @@
  *
  * Author: Ahac Rafael Bela
  * Created on: 08.04.2025
- * Last modified: 14.04.2025
+ * Last modified: 08.05.2025
  *************************************************************/
 //Protection macro
 #pragma once
@@ -16,6 +16,14 @@
 *************************************************************/
 #include "vga.h"
 
+/*************************************************************
+* Macro section
+*************************************************************/
+//Screen the playing field and the instructions are laid out for, drawn at half size on
+//a screen that holds only half of it (a pixel-doubled mode)
+#define SNAKE_SCREEN_WIDTH	800
+#define SNAKE_SCREEN_HEIGHT	600
+
 /*************************************************************
 * Global variable section
 *************************************************************/
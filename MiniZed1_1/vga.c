@@ -4,66 +4,960 @@
 *
 * Author: Ahac Rafael Bela
 * Created on: 01.03.2025
-* Last modified: 14.04.2025
+* Last modified: 17.05.2025
 *************************************************************/
 
 /*************************************************************
 * Include section
 *************************************************************/
 #include "vga.h"
+#include "snake.h"
+#include "kernels.h"
+#include "glyphcache.h"
 
 /*************************************************************
 * Global variable section
 *************************************************************/
-u32 vgaArray[SCREEN_HEIGHT][SCREEN_WIDTH];
-
 point startPoints[256];
 point endPoints[256];
 
+//Screen saved before entering a sub-program
+static pixel savedScreen[FB_MAX_SIZE / sizeof(pixel)] __attribute__((aligned(DMA_BURST_BOUNDARY)));
+static volatile u32 screenCopied;
+
+//Source row for DMA fills and fill progress
+static pixel fillRow[FB_MAX_LINE_BYTES / sizeof(pixel)] __attribute__((aligned(32)));
+static colors fillColor;
+static u32 fillRowValid = 0;
+static u32 fillsSubmitted = 0;
+static volatile u32 fillsCompleted = 0;
+
 /*************************************************************
 * Function definition section
 *************************************************************/
 
 /*************************************************************
-* clearVGA clears the VGA screen.
+* initSurface sets up an offscreen surface in a buffer.
+*
+* @param	s is the surface to set up.
+* @param	base is the buffer, at least height * pitch bytes.
+* @param	width is the number of pixels per row.
+* @param	height is the number of rows.
+* @param	pitch is the number of bytes from one row to the next,
+* 			SURFACE_PITCH(width) for unpadded rows.
+*
+* @return
+* 			- XST_SUCCESS if successful,
+* 			- XST_FAILURE if the rows do not fit the pitch or the
+* 			  buffer and pitch are not whole words.
+*
+* @note		Surfaces have the pixel format of the framebuffers.
+*************************************************************/
+int initSurface(surface *s, pixel *base, u32 width, u32 height, u32 pitch) {
+	//The DMA fills and copies whole words
+	if(pitch < SURFACE_PITCH(width) || pitch % 4 || (UINTPTR) base % 4) return XST_FAILURE;
+
+	*s = (surface){base, width, height, pitch, FB_FORMAT, 0, {{0}}};
+
+	return XST_SUCCESS;
+}
+
+/*************************************************************
+* clearSurface clears a surface.
+*
+* @param	dst is the surface to clear.
+*
+* @return	None.
+*
+* @note		The clear runs asynchronously on the DMA, drawing
+* 			waits for it in putPixel.
+*************************************************************/
+void clearSurface(surface *dst) {
+	fillRows(dst, 0, dst->height, black);
+}
+
+/*************************************************************
+* getClip returns the clip rectangle drawing to a surface is
+* 			limited to.
+*
+* @param	dst is the surface.
+*
+* @return	The clip rectangle pushed last, the whole surface if
+* 			none is.
+*
+* @note		None.
+*************************************************************/
+rect getClip(const surface *dst) {
+	if(dst->clipDepth) return dst->clips[dst->clipDepth - 1];
+
+	return (rect) {0, 0, (s32) dst->width - 1, (s32) dst->height - 1};
+}
+
+/*************************************************************
+* pushClip limits drawing to a surface to a rectangle, until it
+* 			is popped again.
+*
+* @param	dst is the surface.
+* @param	pos0 is the top left point of the rectangle.
+* @param	pos1 is the bottom right point of the rectangle.
+*
+* @return
+* 			- XST_SUCCESS if successful,
+* 			- XST_FAILURE if SURFACE_CLIP_DEPTH rectangles are
+* 			  already pushed.
+*
+* @note		The rectangle is cut to the clip rectangle before it,
+* 			so nested clips only ever shrink. A rectangle outside
+* 			it leaves nothing to draw to.
+*************************************************************/
+int pushClip(surface *dst, point pos0, point pos1) {
+	rect clip = getClip(dst);
+
+	if(dst->clipDepth == SURFACE_CLIP_DEPTH) return XST_FAILURE;
+
+	if(pos0.x > clip.x0) clip.x0 = pos0.x;
+	if(pos0.y > clip.y0) clip.y0 = pos0.y;
+	if(pos1.x < clip.x1) clip.x1 = pos1.x;
+	if(pos1.y < clip.y1) clip.y1 = pos1.y;
+	dst->clips[dst->clipDepth++] = clip;
+
+	return XST_SUCCESS;
+}
+
+/*************************************************************
+* popClip removes the clip rectangle pushed last.
+*
+* @param	dst is the surface.
+*
+* @return	None.
+*
+* @note		Does nothing if none is pushed.
+*************************************************************/
+void popClip(surface *dst) {
+	if(dst->clipDepth) dst->clipDepth--;
+}
+
+/*************************************************************
+* onScreen checks if a surface lies in the draw buffer.
+*
+* @param	s is the surface.
+*
+* @return	1 if the surface is (part of) the draw buffer, 0 otherwise.
+*
+* @note		None.
+*************************************************************/
+static int onScreen(const surface *s) {
+	return (UINTPTR) s->base - (UINTPTR) vgaArray < FB_MAX_SIZE;
+}
+
+/*************************************************************
+* surfaceWritten marks rows of a surface as written by the CPU.
+*
+* @param	dst is the surface.
+* @param	y0 is the first row.
+* @param	rows is the number of rows.
+*
+* @return	None.
+*
+* @note		Only rows of the draw buffer are flushed before scanout,
+* 			offscreen surfaces are flushed when they are copied.
+*************************************************************/
+static void surfaceWritten(const surface *dst, u32 y0, u32 rows) {
+	if(!onScreen(dst)) return;
+	markRowsDirty(((UINTPTR) dst->base - (UINTPTR) vgaArray) / FB_PITCH + y0, rows);
+}
+
+/*************************************************************
+* surfaceChanged marks rows of a surface as written by the DMA.
+*
+* @param	dst is the surface.
+* @param	y0 is the first row.
+* @param	rows is the number of rows.
+*
+* @return	None.
+*
+* @note		The rows need no flush, only present copies them to the
+* 			next draw buffer.
+*************************************************************/
+static void surfaceChanged(const surface *dst, u32 y0, u32 rows) {
+	if(!onScreen(dst)) return;
+	markRowsChanged(((UINTPTR) dst->base - (UINTPTR) vgaArray) / FB_PITCH + y0, rows);
+}
+
+/*************************************************************
+* fillDone is the completion callback of fill copies.
+*
+* @param	callbackRef is unused.
+* @param	status is the status of the copy.
+*
+* @return	None.
+*
+* @note		Runs in the DMA completion interrupt.
+*************************************************************/
+static void fillDone(void *callbackRef, int status) {
+	(void) callbackRef;
+	(void) status;
+	fillsCompleted++;
+}
+
+/*************************************************************
+* dmaFillAvailable checks if fills can use the DMA loopback.
 *
 * @param	None.
 *
+* @return	1 if the DMA can fill, 0 otherwise.
+*
+* @note		None.
+*************************************************************/
+static int dmaFillAvailable(void) {
+	return !XAxiDma_HasSg(ctrls->AxiDma) && ctrls->CfgPtr->HasS2Mm;
+}
+
+#if FB_INDEXED
+/*************************************************************
+* readIndex reads the palette index of one pixel.
+*
+* @param	row is the row to read from.
+* @param	x is the column of the pixel.
+*
+* @return	The palette index.
+*
+* @note		None.
+*************************************************************/
+static inline u8 readIndex(const u8 *row, u32 x) {
+	return row[x / PIXELS_PER_BYTE] >> (x % PIXELS_PER_BYTE * FB_BITS_PER_PIXEL) & PALETTE_INDEX_MASK;
+}
+
+/*************************************************************
+* writeIndex writes the palette index of one pixel.
+*
+* @param	row is the row to write to.
+* @param	x is the column of the pixel.
+* @param	index is the palette index.
+*
+* @return	None.
+*
+* @note		Other pixels sharing the byte are kept.
+*************************************************************/
+static inline void writeIndex(u8 *row, u32 x, u8 index) {
+	u8 *byte = row + x / PIXELS_PER_BYTE;
+	u32 shift = x % PIXELS_PER_BYTE * FB_BITS_PER_PIXEL;
+
+	*byte = (*byte & ~(PALETTE_INDEX_MASK << shift)) | index << shift;
+}
+#endif
+
+/*************************************************************
+* fillSpan fills part of one row with a color.
+*
+* @param	row is the row to fill.
+* @param	x0 is the first column.
+* @param	width is the number of columns.
+* @param	color is the fill color.
+*
 * @return	None.
 *
+* @note		Indexed rows are filled a byte at a time, only the
+* 			bytes shared with pixels outside the span are written
+* 			pixel by pixel. Direct color rows are filled by the
+* 			word kernel, two RGB565 pixels per word.
+*************************************************************/
+static void fillSpan(pixel *row, u32 x0, u32 width, colors color) {
+	pixel value = COLOR_TO_PIXEL(color);
+#if FB_INDEXED
+	u32 end = x0 + width;
+	u8 *bytes = (u8 *) row;
+	u32 x = x0;
+	u32 full;
+
+	for(; x < end && x % PIXELS_PER_BYTE; x++) writeIndex(bytes, x, value);
+	full = (end - x) / PIXELS_PER_BYTE;
+	memset(bytes + x / PIXELS_PER_BYTE, value * (0xFF / PALETTE_INDEX_MASK), full);
+	for(x += full * PIXELS_PER_BYTE; x < end; x++) writeIndex(bytes, x, value);
+#elif FB_FORMAT == FB_FORMAT_RGB565
+	u32 end = x0 + width;
+	u32 pair = value | (u32) value << 16;
+	u32 x = x0;
+
+	//Rows start on a word, a pixel sharing a word with the one before the span is stored on its own
+	if(x < end && x % 2) row[x++] = value;
+	fillWords((u32 *) (row + x), pair, (end - x) / 2);
+	x += (end - x) / 2 * 2;
+	if(x < end) row[x] = value;
+#else
+	fillWords(row + x0, value, width);
+#endif
+}
+
+/*************************************************************
+* copySpan copies part of one row to another row.
+*
+* @param	dstRow is the row to copy to.
+* @param	dx is the first column to copy to.
+* @param	srcRow is the row to copy from.
+* @param	sx is the first column to copy from.
+* @param	width is the number of columns.
+*
+* @return	None.
+*
+* @note		Indexed rows are copied a byte at a time when both
+* 			spans start on a byte, pixel by pixel otherwise. Direct
+* 			color rows are copied by the word kernel when both spans
+* 			start on a word.
+*************************************************************/
+static void copySpan(pixel *dstRow, u32 dx, const pixel *srcRow, u32 sx, u32 width) {
+#if FB_INDEXED
+	u8 *dstBytes = (u8 *) dstRow;
+	const u8 *srcBytes = (const u8 *) srcRow;
+	u32 done = 0;
+
+	if(dx % PIXELS_PER_BYTE == 0 && sx % PIXELS_PER_BYTE == 0) {
+		done = width / PIXELS_PER_BYTE * PIXELS_PER_BYTE;
+		memcpy(dstBytes + dx / PIXELS_PER_BYTE, srcBytes + sx / PIXELS_PER_BYTE, done / PIXELS_PER_BYTE);
+	}
+	for(; done < width; done++) writeIndex(dstBytes, dx + done, readIndex(srcBytes, sx + done));
+#else
+	if(dx % PIXELS_PER_WORD || sx % PIXELS_PER_WORD) {
+		memcpy(dstRow + dx, srcRow + sx, width * sizeof(pixel));
+		return;
+	}
+	u32 words = width / PIXELS_PER_WORD;
+
+	copyWords((u32 *) (dstRow + dx), (const u32 *) (srcRow + sx), words);
+	if(width % PIXELS_PER_WORD) dstRow[dx + width - 1] = srcRow[sx + width - 1];
+#endif
+}
+
+/*************************************************************
+* pixelAddr returns the address of a pixel in a surface.
+*
+* @param	dst is the surface.
+* @param	x is the column of the pixel.
+* @param	y is the row of the pixel.
+*
+* @return	Address of the pixel, or of the byte holding it.
+*
 * @note		None.
 *************************************************************/
-void clearVGA(void) {
-	for(u32 y = 0; y < SCREEN_HEIGHT; y++) {
-		for(u32 x = 0; x < SCREEN_WIDTH; x++) {
-			point pos = {x, y};
-			putPixel(pos, black);
-		}
+static pixel *pixelAddr(const surface *dst, u32 x, u32 y) {
+	return (pixel *) ((u8 *) SURFACE_ROW(dst, y) + PIXEL_BYTES(x));
+}
+
+/*************************************************************
+* prepareFillRow fills the source row with a color, if it does
+* 			not hold that color already.
+*
+* @param	color is the fill color.
+*
+* @return	None.
+*
+* @note		The row is SCREEN_MAX_WIDTH pixels wide, so it serves
+* 			any display mode and surface up to that width.
+*************************************************************/
+static void prepareFillRow(colors color) {
+	if(fillRowValid && fillColor == color) return;
+	//Waiting fills still read the row
+	waitFill();
+	fillSpan(fillRow, 0, SCREEN_MAX_WIDTH, color);
+	Xil_DCacheFlushRange((INTPTR) fillRow, FB_MAX_LINE_BYTES);
+	fillColor = color;
+	fillRowValid = 1;
+}
+
+/*************************************************************
+* flushForFill writes back and drops cached lines of a region
+* 			before the DMA fills it.
+*
+* @param	dst is the surface the region is in.
+* @param	addr is the start of the region.
+* @param	bytes is the size of the region.
+*
+* @return	None.
+*
+* @note		Non-cacheable framebuffers have nothing to flush,
+* 			offscreen surfaces are always cached.
+*************************************************************/
+static void flushForFill(const surface *dst, pixel *addr, u32 bytes) {
+	if(onScreen(dst) && getFramebufferMapping() != FB_MAP_CACHED) return;
+	if(bytes > FILL_FLUSH_ALL_BYTES) Xil_DCacheFlush();
+	else Xil_DCacheFlushRange((INTPTR) addr, bytes);
+}
+
+/*************************************************************
+* submitFill queues one copy of a fill, waiting for room in
+* 			the queue if needed.
+*
+* @param	dst is the destination address.
+* @param	src is the source address.
+* @param	length is the number of bytes to copy.
+*
+* @return
+* 			- XST_SUCCESS if the copy was queued,
+* 			- XST_FAILURE otherwise.
+*
+* @note		The caller flushes once per fill, the copied range is
+* 			still invalidated when the copy is done.
+*************************************************************/
+static int submitFill(pixel *dst, const pixel *src, u32 length) {
+	dmaJob job = {(u32 *) src, (u32 *) dst, length, DMA_PRIO_NORMAL, fillDone, NULL, DMA_FLAG_NO_FLUSH};
+
+	while(dmaQueueFree(DMA_PRIO_NORMAL) == 0);
+	fillsSubmitted++;
+	if(dmaQueueSubmit(&job) != XST_SUCCESS) {
+		fillsSubmitted--;
+		return XST_FAILURE;
+	}
+	return XST_SUCCESS;
+}
+
+/*************************************************************
+* fillCPU fills a rectangle with a color using the CPU.
+*
+* @param	dst is the surface to fill.
+* @param	y0 is the first row.
+* @param	rows is the number of rows.
+* @param	x0 is the first column.
+* @param	width is the number of columns.
+* @param	color is the fill color.
+*
+* @return	None.
+*
+* @note		None.
+*************************************************************/
+static void fillCPU(surface *dst, u32 y0, u32 rows, u32 x0, u32 width, colors color) {
+	waitFill();
+	for(u32 y = y0; y < y0 + rows; y++) fillSpan(SURFACE_ROW(dst, y), x0, width, color);
+	surfaceWritten(dst, y0, rows);
+}
+
+/*************************************************************
+* fillWholeRows fills whole rows with a color. The first row is
+* 			copied from a pre-filled source row, then the filled
+* 			rows are copied over the next ones, doubling each time.
+*
+* @param	dst is the surface to fill.
+* @param	y0 is the first row.
+* @param	rows is the number of rows.
+* @param	color is the fill color.
+*
+* @return	None.
+*
+* @note		Returns as soon as the copies are queued. Surfaces
+* 			wider than the source row are filled by the CPU. The
+* 			rows must be inside the surface.
+*************************************************************/
+static void fillWholeRows(surface *dst, u32 y0, u32 rows, colors color) {
+	pixel *first = SURFACE_ROW(dst, y0);
+
+	if(!dmaFillAvailable() || dst->width > SCREEN_MAX_WIDTH) {
+		fillCPU(dst, y0, rows, 0, dst->width, color);
+		return;
+	}
+	prepareFillRow(color);
+	flushForFill(dst, first, rows * dst->pitch);
+	surfaceChanged(dst, y0, rows);
+
+	if(submitFill(first, fillRow, SURFACE_PITCH(dst->width)) != XST_SUCCESS) {
+		fillCPU(dst, y0, rows, 0, dst->width, color);
+		return;
+	}
+	//Rows are contiguous with their padding, so one copy replicates all filled rows at once
+	for(u32 done = 1; done < rows; done *= 2) {
+		u32 count = (done < rows - done) ? done : rows - done;
+		submitFill(SURFACE_ROW(dst, y0 + done), first, count * dst->pitch);
+	}
+}
+
+/*************************************************************
+* fillRows fills whole rows with a color.
+*
+* @param	dst is the surface to fill.
+* @param	y0 is the first row.
+* @param	rows is the number of rows.
+* @param	color is the fill color.
+*
+* @return	None.
+*
+* @note		A rectangle as wide as the surface, filled by fillRect
+* 			within the clip rectangle.
+*************************************************************/
+void fillRows(surface *dst, u32 y0, u32 rows, colors color) {
+	if(rows == 0) return;
+	fillRect(dst, (point) {0, y0}, (point) {dst->width - 1, y0 + rows - 1}, color);
+}
+
+/*************************************************************
+* fillRect fills a rectangle with a color, one DMA copy of the
+* 			pre-filled source row per rectangle row.
+*
+* @param	dst is the surface to fill.
+* @param	pos0 is the top left point of the rectangle.
+* @param	pos1 is the bottom right point of the rectangle.
+* @param	color is the fill color.
+*
+* @return	None.
+*
+* @note		The rectangle is cut to the clip rectangle first, rows
+* 			as wide as the surface are filled together. Small
+* 			rectangles are filled by the CPU.
+*************************************************************/
+void fillRect(surface *dst, point pos0, point pos1, colors color) {
+	rect clip = getClip(dst);
+
+	if(pos0.x < clip.x0) pos0.x = clip.x0;
+	if(pos0.y < clip.y0) pos0.y = clip.y0;
+	if(pos1.x > clip.x1) pos1.x = clip.x1;
+	if(pos1.y > clip.y1) pos1.y = clip.y1;
+	if(pos1.x < pos0.x || pos1.y < pos0.y) return;
+
+	u32 width = pos1.x - pos0.x + 1;
+	u32 rows = pos1.y - pos0.y + 1;
+
+	if(width == dst->width) {
+		fillWholeRows(dst, pos0.y, rows, color);
+		return;
+	}
+	if(width * rows < FILL_DMA_MIN_PIXELS || width > SCREEN_MAX_WIDTH || !dmaFillAvailable()) {
+		fillCPU(dst, pos0.y, rows, pos0.x, width, color);
+		return;
+	}
+	//DMA addresses and lengths are whole words, pixels sharing a word with the edges are left to the CPU
+	u32 head = (PIXELS_PER_WORD - pos0.x % PIXELS_PER_WORD) % PIXELS_PER_WORD;
+	if(head) {
+		fillCPU(dst, pos0.y, rows, pos0.x, head, color);
+		pos0.x += head;
+		width -= head;
+	}
+	u32 tail = width % PIXELS_PER_WORD;
+	if(tail) {
+		fillCPU(dst, pos0.y, rows, pos0.x + width - tail, tail, color);
+		width -= tail;
+	}
+	if(width == 0) return;
+	prepareFillRow(color);
+	flushForFill(dst, pixelAddr(dst, pos0.x, pos0.y), (rows - 1) * dst->pitch + PIXEL_BYTES(width));
+	surfaceChanged(dst, pos0.y, rows);
+
+	for(s32 y = pos0.y; y <= pos1.y; y++) {
+		submitFill(pixelAddr(dst, pos0.x, y), fillRow, PIXEL_BYTES(width));
+	}
+}
+
+/*************************************************************
+* blitSurface copies a surface into another one, one DMA copy
+* 			per row, or a single one when whole rows of the same
+* 			pitch are copied.
+*
+* @param	dst is the surface to copy to.
+* @param	pos is where the top left pixel of src lands in dst,
+* 			the copy is cut to the clip rectangle of dst.
+* @param	src is the surface to copy from.
+*
+* @return
+* 			- XST_SUCCESS if successful,
+* 			- XST_FAILURE if the surfaces have different formats.
+*
+* @note		Returns as soon as the copies are queued, drawing to
+* 			either surface waits for them. The surfaces must not
+* 			overlap. Narrow copies and copies not starting on a
+* 			word are done by the CPU.
+*************************************************************/
+int blitSurface(surface *dst, point pos, const surface *src) {
+	s32 sx = 0, sy = 0;
+	s32 width = src->width, rows = src->height;
+	rect clip = getClip(dst);
+
+	if(src->format != dst->format) return XST_FAILURE;
+	if(pos.x < clip.x0) { sx = clip.x0 - pos.x; width -= sx; pos.x = clip.x0; }
+	if(pos.y < clip.y0) { sy = clip.y0 - pos.y; rows -= sy; pos.y = clip.y0; }
+	if(pos.x + width > clip.x1 + 1) width = clip.x1 + 1 - pos.x;
+	if(pos.y + rows > clip.y1 + 1) rows = clip.y1 + 1 - pos.y;
+	if(width <= 0 || rows <= 0) return XST_SUCCESS;
+
+	if(PIXEL_BYTES(width) < BLIT_DMA_MIN_ROW_BYTES || !dmaFillAvailable() ||
+			pos.x % PIXELS_PER_WORD || sx % PIXELS_PER_WORD) {
+		waitFill();
+		for(s32 y = 0; y < rows; y++) copySpan(SURFACE_ROW(dst, pos.y + y), pos.x, SURFACE_ROW(src, sy + y), sx, width);
+		surfaceWritten(dst, pos.y, rows);
+		return XST_SUCCESS;
+	}
+	//Pixels sharing a word with the right edge are left to the CPU, before the flush drops their lines
+	u32 tail = width % PIXELS_PER_WORD;
+	width -= tail;
+	if(tail) {
+		waitFill();
+		for(s32 y = 0; y < rows; y++) copySpan(SURFACE_ROW(dst, pos.y + y), pos.x + width, SURFACE_ROW(src, sy + y), sx + width, tail);
+		surfaceWritten(dst, pos.y, rows);
+	}
+	//The DMA reads what the CPU drew to the source
+	Xil_DCacheFlushRange((INTPTR) pixelAddr(src, sx, sy), (rows - 1) * src->pitch + PIXEL_BYTES(width));
+	flushForFill(dst, pixelAddr(dst, pos.x, pos.y), (rows - 1) * dst->pitch + PIXEL_BYTES(width));
+	surfaceChanged(dst, pos.y, rows);
+
+	if(src->pitch == dst->pitch && (u32) PIXEL_BYTES(width) == dst->pitch) {
+		submitFill(pixelAddr(dst, pos.x, pos.y), pixelAddr(src, sx, sy), rows * dst->pitch);
+		return XST_SUCCESS;
+	}
+	for(s32 y = 0; y < rows; y++) {
+		submitFill(pixelAddr(dst, pos.x, pos.y + y), pixelAddr(src, sx, sy + y), PIXEL_BYTES(width));
 	}
+
+	return XST_SUCCESS;
+}
+
+/*************************************************************
+* waitFill waits until all DMA fills are done.
+*
+* @param	None.
+*
+* @return	None.
+*
+* @note		None.
+*************************************************************/
+void waitFill(void) {
+	while(fillsCompleted != fillsSubmitted);
+}
+
+/*************************************************************
+* screenCopyDone is the completion callback of screen copies.
+*
+* @param	callbackRef is unused.
+* @param	status is the status of the copy.
+*
+* @return	None.
+*
+* @note		Runs in the DMA completion interrupt.
+*************************************************************/
+static void screenCopyDone(void *callbackRef, int status) {
+	(void) callbackRef;
+	(void) status;
+	screenCopied = 1;
+}
+
+/*************************************************************
+* saveScreen saves the drawn screen using the DMA as a memcpy
+* 			engine and waits for the copy to finish.
+*
+* @param	None.
+*
+* @return
+* 			- XST_SUCCESS if the screen was saved,
+* 			- XST_FAILURE if the DMA could not take the copy.
+*
+* @note		None.
+*************************************************************/
+int saveScreen(void) {
+	screenCopied = 0;
+	if(dmaCopyAsync((u32 *) savedScreen, (u32 *) screenSurface.base, FB_SIZE, screenCopyDone, NULL) != XST_SUCCESS) return XST_FAILURE;
+	//The screen is about to be drawn over
+	while(!screenCopied);
+
+	return XST_SUCCESS;
+}
+
+/*************************************************************
+* restoreScreen restores the screen saved by saveScreen using
+* 			the DMA as a memcpy engine and presents it.
+*
+* @param	None.
+*
+* @return
+* 			- XST_SUCCESS if the screen was restored,
+* 			- XST_FAILURE if the DMA could not take the copy.
+*
+* @note		None.
+*************************************************************/
+int restoreScreen(void) {
+	screenCopied = 0;
+	if(dmaCopyAsync((u32 *) screenSurface.base, (u32 *) savedScreen, FB_SIZE, screenCopyDone, NULL) != XST_SUCCESS) return XST_FAILURE;
+	while(!screenCopied);
+	markRowsChanged(0, SCREEN_HEIGHT);
+	present();
+
+	return XST_SUCCESS;
+}
+
+/*************************************************************
+* plotPixel draws a pixel without clipping it.
+*
+* @param	dst is the surface to draw to.
+* @param	pos is the location of the pixel (x, y), inside the
+* 			clip rectangle.
+* @param	color is the color of the pixel.
+*
+* @return	None.
+*
+* @note		None.
+*************************************************************/
+static void plotPixel(surface *dst, point pos, colors color) {
+	u8 *screen = (u8 *) dst->base;
+	u32 where = PIXEL_BYTES(pos.x) + pos.y * dst->pitch;
+
+	//The DMA may still be filling the surface
+	if(fillsCompleted != fillsSubmitted) waitFill();
+
+#if FB_INDEXED
+	//Other pixels sharing the byte are kept
+	u32 shift = pos.x % PIXELS_PER_BYTE * FB_BITS_PER_PIXEL;
+	screen[where] = (screen[where] & ~(PALETTE_INDEX_MASK << shift)) | COLOR_TO_PIXEL(color) << shift;
+#else
+	//One store of the whole pixel
+	*(pixel *) (screen + where) = COLOR_TO_PIXEL(color);
+#endif
+	surfaceWritten(dst, pos.y, 1);
 }
 
 /*************************************************************
 * putPixel draws a pixel.
 *
+* @param	dst is the surface to draw to.
 * @param	pos is the location of the pixel (x, y).
 * @param	color is the color of the pixel.
 *
 * @return	None.
 *
+* @note		Pixels outside the clip rectangle are not drawn.
+*************************************************************/
+void putPixel(surface *dst, point pos, colors color) {
+	rect clip = getClip(dst);
+
+	if(pos.x < clip.x0 || pos.x > clip.x1 || pos.y < clip.y0 || pos.y > clip.y1) return;
+	plotPixel(dst, pos, color);
+}
+
+/*************************************************************
+* hspan draws a horizontal run of pixels.
+*
+* @param	dst is the surface to draw to.
+* @param	y is the row of the run.
+* @param	x0 is one end of the run.
+* @param	x1 is the other end of the run.
+* @param	color is the color of the run.
+*
+* @return	None.
+*
+* @note		Both ends are drawn, the run is cut to the clip
+* 			rectangle first. Whole words (whole bytes of indices)
+* 			are stored, only the pixels sharing them with pixels
+* 			outside the run are stored one by one. The row is
+* 			marked written once.
+*************************************************************/
+void hspan(surface *dst, s32 y, s32 x0, s32 x1, colors color) {
+	rect clip = getClip(dst);
+
+	if(x1 < x0) {
+		s32 x = x0;
+		x0 = x1;
+		x1 = x;
+	}
+	if(x0 < clip.x0) x0 = clip.x0;
+	if(x1 > clip.x1) x1 = clip.x1;
+	if(y < clip.y0 || y > clip.y1 || x1 < x0) return;
+	//The DMA may still be filling the surface
+	if(fillsCompleted != fillsSubmitted) waitFill();
+
+	fillSpan(SURFACE_ROW(dst, y), x0, x1 - x0 + 1, color);
+	surfaceWritten(dst, y, 1);
+}
+
+/*************************************************************
+* vspan draws a vertical run of pixels.
+*
+* @param	dst is the surface to draw to.
+* @param	x is the column of the run.
+* @param	y0 is one end of the run.
+* @param	y1 is the other end of the run.
+* @param	color is the color of the run.
+*
+* @return	None.
+*
+* @note		Both ends are drawn, the run is cut to the clip
+* 			rectangle first. The pixel is converted and its address
+* 			worked out once, then one store per row follows the
+* 			pitch. The rows are marked written once.
+*************************************************************/
+void vspan(surface *dst, s32 x, s32 y0, s32 y1, colors color) {
+	pixel value = COLOR_TO_PIXEL(color);
+	rect clip = getClip(dst);
+
+	if(y1 < y0) {
+		s32 y = y0;
+		y0 = y1;
+		y1 = y;
+	}
+	if(y0 < clip.y0) y0 = clip.y0;
+	if(y1 > clip.y1) y1 = clip.y1;
+	if(x < clip.x0 || x > clip.x1 || y1 < y0) return;
+	if(fillsCompleted != fillsSubmitted) waitFill();
+
+#if FB_INDEXED
+	u8 *byte = (u8 *) SURFACE_ROW(dst, y0) + x / PIXELS_PER_BYTE;
+	u32 shift = x % PIXELS_PER_BYTE * FB_BITS_PER_PIXEL;
+	u8 keep = ~(PALETTE_INDEX_MASK << shift), bits = value << shift;
+
+	for(s32 y = y0; y <= y1; y++, byte += dst->pitch) *byte = (*byte & keep) | bits;
+#else
+	u8 *addr = (u8 *) pixelAddr(dst, x, y0);
+
+	for(s32 y = y0; y <= y1; y++, addr += dst->pitch) *(pixel *) addr = value;
+#endif
+	surfaceWritten(dst, y0, y1 - y0 + 1);
+}
+
+/*************************************************************
+* applyOp combines a pixel with the pixel under it.
+*
+* @param	under is the pixel under it, or its palette index.
+* @param	value is the pixel, or its palette index.
+* @param	op is how they are combined.
+*
+* @return	The combined pixel.
+*
 * @note		None.
 *************************************************************/
-void putPixel(point pos, colors color) {
-	u8 *screen = (u8 *) *vgaArray;
-	u32 where = pos.x * PIXEL_WIDTH + pos.y * PITCH;
+static inline pixel applyOp(pixel under, pixel value, rasterOp op) {
+	switch(op) {
+	case ROP_XOR: return under ^ value;
+	case ROP_OR: return under | value;
+	case ROP_AND: return under & value;
+	default: return value;
+	}
+}
+
+/*************************************************************
+* hspanOp combines a horizontal run of pixels with the pixels
+* 			under it.
+*
+* @param	dst is the surface to draw to.
+* @param	y is the row of the run.
+* @param	x0 is one end of the run.
+* @param	x1 is the other end of the run.
+* @param	color is the color of the run.
+* @param	op is how the run is combined with the pixels under it.
+*
+* @return	None.
+*
+* @note		Clipped like hspan, which draws ROP_COPY runs. The
+* 			other operations read each pixel back and store it
+* 			again. The row is marked written once.
+*************************************************************/
+void hspanOp(surface *dst, s32 y, s32 x0, s32 x1, colors color, rasterOp op) {
+	pixel value = COLOR_TO_PIXEL(color);
+	rect clip = getClip(dst);
+
+	if(op == ROP_COPY) {
+		hspan(dst, y, x0, x1, color);
+		return;
+	}
+	if(x1 < x0) {
+		s32 x = x0;
+		x0 = x1;
+		x1 = x;
+	}
+	if(x0 < clip.x0) x0 = clip.x0;
+	if(x1 > clip.x1) x1 = clip.x1;
+	if(y < clip.y0 || y > clip.y1 || x1 < x0) return;
+	if(fillsCompleted != fillsSubmitted) waitFill();
+
+#if FB_INDEXED
+	u8 *row = (u8 *) SURFACE_ROW(dst, y);
+
+	for(s32 x = x0; x <= x1; x++) writeIndex(row, x, applyOp(readIndex(row, x), value, op));
+#else
+	pixel *row = SURFACE_ROW(dst, y);
+
+	for(s32 x = x0; x <= x1; x++) row[x] = applyOp(row[x], value, op);
+#endif
+	surfaceWritten(dst, y, 1);
+}
+
+/*************************************************************
+* vspanOp combines a vertical run of pixels with the pixels
+* 			under it.
+*
+* @param	dst is the surface to draw to.
+* @param	x is the column of the run.
+* @param	y0 is one end of the run.
+* @param	y1 is the other end of the run.
+* @param	color is the color of the run.
+* @param	op is how the run is combined with the pixels under it.
+*
+* @return	None.
+*
+* @note		Clipped like vspan, which draws ROP_COPY runs. The rows
+* 			are marked written once.
+*************************************************************/
+void vspanOp(surface *dst, s32 x, s32 y0, s32 y1, colors color, rasterOp op) {
+	pixel value = COLOR_TO_PIXEL(color);
+	rect clip = getClip(dst);
+
+	if(op == ROP_COPY) {
+		vspan(dst, x, y0, y1, color);
+		return;
+	}
+	if(y1 < y0) {
+		s32 y = y0;
+		y0 = y1;
+		y1 = y;
+	}
+	if(y0 < clip.y0) y0 = clip.y0;
+	if(y1 > clip.y1) y1 = clip.y1;
+	if(x < clip.x0 || x > clip.x1 || y1 < y0) return;
+	if(fillsCompleted != fillsSubmitted) waitFill();
+
+	for(s32 y = y0; y <= y1; y++) {
+#if FB_INDEXED
+		u8 *row = (u8 *) SURFACE_ROW(dst, y);
+
+		writeIndex(row, x, applyOp(readIndex(row, x), value, op));
+#else
+		pixel *addr = pixelAddr(dst, x, y);
+
+		*addr = applyOp(*addr, value, op);
+#endif
+	}
+	surfaceWritten(dst, y0, y1 - y0 + 1);
+}
+
+/*************************************************************
+* expandGlyph expands the rows of a character into a slot of the
+* 			glyph cache.
+*
+* @param	rows is the first row of the slot.
+* @param	letter is the first row of the character in the font.
+* @param	scale is the scale of the character.
+* @param	fgcolor is the color of the character.
+* @param	bgcolor is the background color of the character.
+*
+* @return	None.
+*
+* @note		XRGB8888 rows are written by the two-color expand
+* 			kernel, the other formats fill runs of equal bits.
+*************************************************************/
+static void expandGlyph(pixel *rows, const u8 *letter, u32 scale, colors fgcolor, colors bgcolor) {
+	for(u32 i = 0; i < CHAR_HEIGHT; i++, rows += GLYPH_ROW_PIXELS) {
+#if FB_FORMAT == FB_FORMAT_XRGB8888
+		//Each bit of the glyph row repeated scale times, from the top bit of the mask down
+		u32 bits = 0;
+		for(u32 j = 0; j < CHAR_WIDTH; j++) {
+			if(letter[i] & (0x80 >> j)) bits |= ((1U << scale) - 1) << (32 - (j + 1) * scale);
+		}
+		expandWords(rows, bits, CHAR_WIDTH * scale, COLOR_TO_PIXEL(fgcolor), COLOR_TO_PIXEL(bgcolor));
+#else
+		for(u32 j = 0, end; j < CHAR_WIDTH; j = end) {
+			u32 bit = letter[i] & (0x80 >> j);
 
-	screen[where] = color;				//RED
-	screen[where + 1] = color >> 8;		//GREEN
-	screen[where + 2] = color >> 16;	//BLUE
+			for(end = j + 1; end < CHAR_WIDTH && !(letter[i] & (0x80 >> end)) == !bit; end++);
+			fillSpan(rows, j * scale, (end - j) * scale, bit ? fgcolor : bgcolor);
+		}
+#endif
+	}
 }
 
 /*************************************************************
 * drawChar draws a character.
 *
+* @param	dst is the surface to draw to.
 * @param	c is the character to be drawn.
 * @param	pos is the location of the character (x, y).
 * @param	scale is the scale of the character.
@@ -72,17 +966,42 @@ void putPixel(point pos, colors color) {
 *
 * @return	None.
 *
-* @note	None.
+* @note	Characters outside the clip rectangle are skipped whole.
+* 			Characters inside it up to GLYPH_CACHE_MAX_SCALE are
+* 			copied row by row from the glyph cache, expanded there
+* 			on a miss. Otherwise each row is drawn as runs of equal
+* 			bits, one hspan per run and scaled row, which cuts the
+* 			runs to the clip rectangle.
 *************************************************************/
-void drawChar(u8 c, point pos, u32 scale, colors fgcolor, colors bgcolor) {
-	u32 i, j;
-	u32 mask[8] = {128, 64, 32, 16, 8, 4, 2, 1};
-	u8 *letter = IBM_VGA_8x16 + (u32) c * 16;
+void drawChar(surface *dst, u8 c, point pos, u32 scale, colors fgcolor, colors bgcolor) {
+	const u8 *letter = IBM_VGA_8x16 + (u32) c * CHAR_HEIGHT;
+	rect clip = getClip(dst);
+	s32 right = pos.x + (s32) (CHAR_WIDTH * scale) - 1, bottom = pos.y + (s32) (CHAR_HEIGHT * scale) - 1;
+
+	if(pos.x > clip.x1 || pos.y > clip.y1 || right < clip.x0 || bottom < clip.y0) return;
+
+	if(scale <= GLYPH_CACHE_MAX_SCALE && pos.x >= clip.x0 && pos.y >= clip.y0 && right <= clip.x1 && bottom <= clip.y1) {
+		int found;
+		pixel *rows = findGlyph(c, scale, COLOR_TO_PIXEL(fgcolor), COLOR_TO_PIXEL(bgcolor), &found);
+
+		if(!found) expandGlyph(rows, letter, scale, fgcolor, bgcolor);
+		if(fillsCompleted != fillsSubmitted) waitFill();
+		for(u32 i = 0; i < CHAR_HEIGHT; i++, rows += GLYPH_ROW_PIXELS) {
+			for(u32 k = 0, y = pos.y + i * scale; k < scale; k++, y++) copySpan(SURFACE_ROW(dst, y), pos.x, rows, 0, CHAR_WIDTH * scale);
+		}
+		surfaceWritten(dst, pos.y, CHAR_HEIGHT * scale);
+		return;
+	}
+
+	for(u32 i = 0; i < CHAR_HEIGHT; i++) {
+		for(s32 k = 0, y = pos.y + i * scale; k < (s32) scale; k++, y++) {
+			if(y < clip.y0 || y > clip.y1) continue;
+			for(u32 j = 0, end; j < CHAR_WIDTH; j = end) {
+				u32 bit = letter[i] & (0x80 >> j);
 
-	for(i = 0 ; i < (16 * scale); i++){
-		for(j = 0; j < (8 * scale); j++){
-			point newPos = {pos.x + j, pos.y + i};
-			putPixel( newPos, (letter[i / scale] & mask[j / scale]) ? fgcolor : bgcolor);
+				for(end = j + 1; end < CHAR_WIDTH && !(letter[i] & (0x80 >> end)) == !bit; end++);
+				hspan(dst, y, pos.x + j * scale, pos.x + end * scale - 1, bit ? fgcolor : bgcolor);
+			}
 		}
 	}
 }
@@ -90,6 +1009,7 @@ void drawChar(u8 c, point pos, u32 scale, colors fgcolor, colors bgcolor) {
 /*************************************************************
 * drawText draws a text.
 *
+* @param	dst is the surface to draw to.
 * @param	text is the text to be drawn.
 * @param	textP is the top left location of the text.
 * @param	scale is the scale of the text.
@@ -98,70 +1018,42 @@ void drawChar(u8 c, point pos, u32 scale, colors fgcolor, colors bgcolor) {
 *
 * @return	None.
 *
-* @note		None.
+* @note		Stops at the first character right of the clip
+* 			rectangle.
 *************************************************************/
-void drawText(const char *text, point textP, u32 scale, colors fgcolor, colors bgcolor) {
+void drawText(surface *dst, const char *text, point textP, u32 scale, colors fgcolor, colors bgcolor) {
+	rect clip = getClip(dst);
+
 	for(u32 i = 0; text[i]; i++) {
 		point pos = {textP.x + i * CHAR_WIDTH * scale, textP.y};
-		drawChar(text[i], pos, scale, fgcolor, bgcolor);
+
+		if(pos.x > clip.x1) break;
+		drawChar(dst, text[i], pos, scale, fgcolor, bgcolor);
 	}
 }
 
 /*************************************************************
 * drawStraight draws a straight line.
 *
+* @param	dst is the surface to draw to.
 * @param	pos0 is starting location of the line.
 * @param	pos1 is ending location of the line.
 * @param	color is the color of the line.
 *
 * @return	None.
 *
-* @note		None.
+* @note		Drawn as one hspan or vspan.
 *************************************************************/
-void drawStraight(point pos0, point pos1, u32 color) {
-	int dx = 0, dy = 0;
-	//Horizontal or vertical and which direction
-	if(pos1.x == pos0.x) {
-		//Vertical line
-		if(pos1.y > pos0.y) {
-			//Vertical line moving down
-			dy = 1;
-		} else {
-			//Vertical line moving up
-			dy = -1;
-		}
-	} else if(pos1.x > pos0.x) {
-		//Horizontal line moving right
-		dx = 1;
-	} else {
-		//Horizontal line moving left
-		dx = -1;
-	}
-	if(dx != 0) {
-		//Horizontal line
-		while(1) {
-			putPixel(pos0, color);
-			pos0.x += dx;
-			if(pos0.x == pos1.x) {
-				putPixel(pos0, color);
-				break;
-			}
-		}
-	} else {
-		while(1) {
-			putPixel(pos0, color);
-			pos0.y += dy;
-			if(pos0.y == pos1.y) {
-				putPixel(pos0, color);
-				break;
-			}
-		}
-	}
+void drawStraight(surface *dst, point pos0, point pos1, u32 color) {
+	//Vertical if both ends share a column, horizontal on the row of pos0 otherwise
+	if(pos1.x == pos0.x) vspan(dst, pos0.x, pos0.y, pos1.y, color);
+	else hspan(dst, pos0.y, pos0.x, pos1.x, color);
 }
 
 /*************************************************************
 * drawBox draws a box.
 *
+* @param	dst is the surface to draw to.
 * @param	pos0 is the top left point of the box.
 * @param	pos1 is the bottom right point of the box.
 * @param	color is the color of the box.
@@ -170,7 +1062,7 @@ void drawStraight(point pos0, point pos1, u32 color) {
 *
 * @note		None.
 *************************************************************/
-void drawBox(point pos0, point pos1, colors color) {
+void drawBox(surface *dst, point pos0, point pos1, colors color) {
 	point topL = pos0;
 	point topR = {pos1.x, pos0.y};
 	point leftT = pos0;
@@ -180,40 +1072,32 @@ void drawBox(point pos0, point pos1, colors color) {
 	point botL = {pos0.x, pos1.y};
 	point botR = {pos1.x, pos0.y};
 
-	drawStraight(topL, topR, color);	//top line
-	drawStraight(leftT, leftB, color);	//left line
-	drawStraight(rightT, rightB, color);	//right line
-	drawStraight(botL, botR, color);	//bottom line
+	drawStraight(dst, topL, topR, color);	//top line
+	drawStraight(dst, leftT, leftB, color);	//left line
+	drawStraight(dst, rightT, rightB, color);	//right line
+	drawStraight(dst, botL, botR, color);	//bottom line
 }
 
 /*************************************************************
 * drawBoxFull draws a filled box.
 *
+* @param	dst is the surface to draw to.
 * @param	pos0 is the top left point of the box.
 * @param	pos1 is the bottom right point of the box.
 * @param	color is the color of the box.
 *
 * @return	None.
 *
-* @note		None.
+* @note		Large boxes are filled by the DMA.
 *************************************************************/
-void drawBoxFull(point pos0, point pos1, colors color) {
-	point tmp = (point) {pos0.x, pos0.y};
-	while(tmp.x != pos1.x || tmp.y != pos1.y) {
-		putPixel(tmp, color);
-		if(tmp.x != pos1.x) {
-			tmp.x++;
-		} else {
-			tmp.x = pos0.x;
-			tmp.y++;
-		}
-	}
-	putPixel(tmp, color);
+void drawBoxFull(surface *dst, point pos0, point pos1, colors color) {
+	fillRect(dst, pos0, pos1, color);
 }
 
 /*************************************************************
  * drawSelector draws a selector box.
  *
+ * @param	dst is the surface to draw to.
  * @param	tL is the top left point of the selector box.
  * @param	color is the color of the selector box.
  *
@@ -221,7 +1105,7 @@ void drawBoxFull(point pos0, point pos1, colors color) {
  *
  * @note	None.
  *************************************************************/
-void drawSelector(point tL, colors color) {
+void drawSelector(surface *dst, point tL, colors color) {
 	int offset = 16;
 	int height = 32;
 	int width = 224;
@@ -252,21 +1136,46 @@ void drawSelector(point tL, colors color) {
 	point bRoff2 = {bR.x - offset, bR.y};
 
 	//Draws left segment of the top line of the selector
-	drawStraight(tL, tLoff1, color);
+	drawStraight(dst, tL, tLoff1, color);
 	//Draws right segment of the top line of the selector
-	drawStraight(tRoff1, tR, color);
+	drawStraight(dst, tRoff1, tR, color);
 	//Draws top segment of the left line of the selector
-	drawStraight(tL, tLoff2, color);
+	drawStraight(dst, tL, tLoff2, color);
 	//Draws bottom segment of the left line of the selector
-	drawStraight(bLoff1, bL, color);
+	drawStraight(dst, bLoff1, bL, color);
 	//Draws top segment of the right line of the selector
-	drawStraight(tR, tRoff2, color);
+	drawStraight(dst, tR, tRoff2, color);
 	//Draws bottom segment of the right line of the selector
-	drawStraight(bRoff1, bR, color);
+	drawStraight(dst, bRoff1, bR, color);
 	//Draws left segment of the bottom line of the selector
-	drawStraight(bL, bLoff2, color);
+	drawStraight(dst, bL, bLoff2, color);
 	//Draws right segment of the bottom line of the selector
-	drawStraight(bRoff2, bR, color);
+	drawStraight(dst, bRoff2, bR, color);
+}
+
+/**************************************************************
+ * initSelectors sets the selector and text coordinates of the
+ * 			menu for the current display mode.
+ *
+ * @param	None.
+ *
+ * @return	None.
+ *
+ * @note	Called on startup and after the display mode changed.
+ *************************************************************/
+void initSelectors(void) {
+	selectorWText1 = (selectorWText){{SELECTOR_X, SELECTOR_Y(1)},
+					{SCREEN_WIDTH / 2 - strlen("Echo") * CHAR_WIDTH, (SELECTOR_Y(1) + SELECTOR_PADDING)},
+					"Echo"};
+	selectorWText2 = (selectorWText){{SELECTOR_X, SELECTOR_Y(2)},
+					{SCREEN_WIDTH / 2 - strlen("Lines") * CHAR_WIDTH, (SELECTOR_Y(2) + SELECTOR_PADDING)},
+					"Lines"};
+	selectorWText3 = (selectorWText){{SELECTOR_X, SELECTOR_Y(3)},
+					{SCREEN_WIDTH / 2 - strlen("Exit") * CHAR_WIDTH, (SELECTOR_Y(3) + SELECTOR_PADDING)},
+					"Exit"};
+	selectorWText4 = (selectorWText){{SELECTOR_X, SELECTOR_Y(4)},
+					{SCREEN_WIDTH / 2 - strlen("Extras") * CHAR_WIDTH, (SELECTOR_Y(4) + SELECTOR_PADDING)},
+					"Extras"};
 }
 
 /**************************************************************
@@ -279,15 +1188,15 @@ void drawSelector(point tL, colors color) {
  * @note	None.
  *************************************************************/
 void drawMenu(void) {
-	drawText("MiniZed 1.0", (point){0, 0}, 4, white, d_gray);
+	drawText(&screenSurface, "MiniZed 1.0", (point){0, 0}, 4, white, d_gray);
 
-	drawSelector(selectorWText1.selector, white);
-	drawSelector(selectorWText2.selector, d_gray);
-	drawSelector(selectorWText3.selector, d_gray);
+	drawSelector(&screenSurface, selectorWText1.selector, white);
+	drawSelector(&screenSurface, selectorWText2.selector, d_gray);
+	drawSelector(&screenSurface, selectorWText3.selector, d_gray);
 
-	drawText(selectorWText1.menuText, selectorWText1.menu, 2, white, black);
-	drawText(selectorWText2.menuText, selectorWText2.menu, 2, d_gray, black);
-	drawText(selectorWText3.menuText, selectorWText3.menu, 2, d_gray, black);
+	drawText(&screenSurface, selectorWText1.menuText, selectorWText1.menu, 2, white, black);
+	drawText(&screenSurface, selectorWText2.menuText, selectorWText2.menu, 2, d_gray, black);
+	drawText(&screenSurface, selectorWText3.menuText, selectorWText3.menu, 2, d_gray, black);
 }
 
 /**************************************************************
@@ -301,8 +1210,28 @@ void drawMenu(void) {
  * @note	None.
  *************************************************************/
 void drawStage(void) {
-	clearVGA();
+	clearSurface(&screenSurface);
 	drawMenu();
+	present();
+}
+
+/**************************************************************
+ * drawHeader clears the screen and draws the header of a
+ * 			sub-program at the top.
+ *
+ * @param	text is the header, padded to the width of the screen.
+ *
+ * @return	None.
+ *
+ * @note	The header is drawn at the largest scale that fits the
+ * 			width of the display mode, at least 1.
+ *************************************************************/
+static void drawHeader(const char *text) {
+	u32 scale = SCREEN_WIDTH / (strlen(text) * CHAR_WIDTH);
+
+	clearSurface(&screenSurface);
+	drawText(&screenSurface, text, (point) {0, 0}, scale ? scale : 1, white, d_gray);
+	present();
 }
 
 /**************************************************************
@@ -315,8 +1244,7 @@ void drawStage(void) {
  * @note	None.
  *************************************************************/
 void drawEcho(void) {
-	clearVGA();
-	drawText("MiniZed 1.0: Echo                    (ESC to exit)", (point) {0, 0}, 2, white, d_gray);
+	drawHeader("MiniZed 1.0: Echo                    (ESC to exit)");
 }
 
 /**************************************************************
@@ -329,8 +1257,7 @@ void drawEcho(void) {
  * @note	None.
  *************************************************************/
 void drawLines(void) {
-	clearVGA();
-	drawText("MiniZed 1.0: Lines                   (ESC to exit)", (point) {0, 0}, 2, white, d_gray);
+	drawHeader("MiniZed 1.0: Lines                   (ESC to exit)");
 }
 
 /**************************************************************
@@ -343,8 +1270,9 @@ void drawLines(void) {
  * @note	None.
  *************************************************************/
 void drawExit(void) {
-	clearVGA();
-	drawText("Goodbye!", (point) {336, 268}, 2, white, black);
+	clearSurface(&screenSurface);
+	drawText(&screenSurface, "Goodbye!", (point) {336, 268}, 2, white, black);
+	present();
 	usleep(10000);
 }
 
@@ -358,8 +1286,7 @@ void drawExit(void) {
  * @note	None.
  *************************************************************/
 void drawExtras(void) {
-	clearVGA();
-	drawText("MiniZed 1.0: Snake                   (ESC to exit)", (point) {0, 0}, 2, white, d_gray);
+	drawHeader("MiniZed 1.0: Snake                   (ESC to exit)");
 }
 
 /*************************************************************
@@ -372,7 +1299,7 @@ void drawExtras(void) {
 * @note		None.
 *************************************************************/
 void selectSelector(point selector) {
-	drawSelector(selector, white);
+	drawSelector(&screenSurface, selector, white);
 }
 
 /*************************************************************
@@ -385,7 +1312,7 @@ void selectSelector(point selector) {
 * @note		None.
 *************************************************************/
 void unselectSelector(point selector) {
-	drawSelector(selector, d_gray);
+	drawSelector(&screenSurface, selector, d_gray);
 }
 
 /*************************************************************
@@ -402,15 +1329,15 @@ void unselectAll() {
 	unselectSelector(selectorWText2.selector);
 	unselectSelector(selectorWText3.selector);
 	if(discovered) {
-		drawSelector(selectorWText4.selector, l_red);
-	} else drawSelector(selectorWText4.selector, black);
+		drawSelector(&screenSurface, selectorWText4.selector, l_red);
+	} else drawSelector(&screenSurface, selectorWText4.selector, black);
 
-	drawText(selectorWText1.menuText, selectorWText1.menu, 2, d_gray, black);
-	drawText(selectorWText2.menuText, selectorWText2.menu, 2, d_gray, black);
-	drawText(selectorWText3.menuText, selectorWText3.menu, 2, d_gray, black);
+	drawText(&screenSurface, selectorWText1.menuText, selectorWText1.menu, 2, d_gray, black);
+	drawText(&screenSurface, selectorWText2.menuText, selectorWText2.menu, 2, d_gray, black);
+	drawText(&screenSurface, selectorWText3.menuText, selectorWText3.menu, 2, d_gray, black);
 	if(discovered) {
-		drawText(selectorWText4.menuText, selectorWText4.menu, 2, l_red, black);
-	} else drawText(selectorWText4.menuText, selectorWText4.menu, 2, black, black);
+		drawText(&screenSurface, selectorWText4.menuText, selectorWText4.menu, 2, l_red, black);
+	} else drawText(&screenSurface, selectorWText4.menuText, selectorWText4.menu, 2, black, black);
 }
 
 /*************************************************************
@@ -427,7 +1354,7 @@ void selectSelectorWText(selectorWText selectorWText) {
 
 	if(selectorWText.menu.y != selectorWText4.menu.y) {
 		selectSelector(selectorWText.selector);
-	} else drawSelector(selectorWText.selector, red);
+	} else drawSelector(&screenSurface, selectorWText.selector, red);
 }
 
 /*************************************************************
@@ -444,10 +1371,10 @@ void selectMenu(selectorWText selectorWText) {
 
 	selectSelector(selectorWText.selector);
 	if(selectorWText.menu.y != selectorWText4.menu.y) {
-		drawText(selectorWText.menuText, selectorWText.menu, 2, white, black);
+		drawText(&screenSurface, selectorWText.menuText, selectorWText.menu, 2, white, black);
 	} else {
-		drawSelector(selectorWText.selector, red);
-		drawText(selectorWText.menuText, selectorWText.menu, 2, red, black);
+		drawSelector(&screenSurface, selectorWText.selector, red);
+		drawText(&screenSurface, selectorWText.menuText, selectorWText.menu, 2, red, black);
 	}
 }
 
@@ -462,20 +1389,13 @@ void selectMenu(selectorWText selectorWText) {
  * @note	None.
  *************************************************************/
 void enterMenu(selectorWText selectorWText) {
-	switch(selectorWText.selector.y) {
-		case SELECTOR_Y(1):
-			enterEcho();
-			break;
-		case SELECTOR_Y(2):
-			enterLines();
-			break;
-		case SELECTOR_Y(3):
-			enterExit();
-			break;
-		case SELECTOR_Y(4):
-			enterExtras();
-			break;
-	}
+	int y = selectorWText.selector.y;
+
+	//Selector rows follow the display mode, so they are compared rather than switched on
+	if(y == SELECTOR_Y(1)) enterEcho();
+	else if(y == SELECTOR_Y(2)) enterLines();
+	else if(y == SELECTOR_Y(3)) enterExit();
+	else if(y == SELECTOR_Y(4)) enterExtras();
 }
 
 /*************************************************************
@@ -488,6 +1408,8 @@ void enterMenu(selectorWText selectorWText) {
  * @note	None.
  *************************************************************/
 void enterEcho(void) {
+	//Keep the menu, so it does not have to be redrawn on exit
+	int menuSaved = saveScreen();
 	drawEcho();
 	static point index = {0, 32};
 	int doPrint = 0;
@@ -510,7 +1432,10 @@ void enterEcho(void) {
 				doPrint = 0;
 			} else if(caughtChar != 0xD) doPrint = 1;
 
-			if(doPrint) drawText(caughtWord, index, 1, white, black);
+			if(doPrint) {
+				drawText(&screenSurface, caughtWord, index, 1, white, black);
+				present();
+			}
 
 			if(index.x < (SCREEN_WIDTH - CHAR_WIDTH))index.x += CHAR_WIDTH;
 			else if((index.y + 15) < (SCREEN_HEIGHT - CHAR_HEIGHT)) {
@@ -522,7 +1447,22 @@ void enterEcho(void) {
 		}
 	} while (caughtChar != 0x1B);
 	index = (point) {0, 32};
-	clearVGA();
+	if(menuSaved != XST_SUCCESS || restoreScreen() != XST_SUCCESS) drawStage();
+}
+
+/*************************************************************
+ * returnToMenu switches back to the display mode of the menu
+ * 			and draws the menu.
+ *
+ * @param	menuMode is the display mode the menu was shown in.
+ *
+ * @return	None.
+ *
+ * @note	None.
+ *************************************************************/
+static void returnToMenu(displayModeId menuMode) {
+	//Laid out for the mode of the menu again
+	if(getDisplayMode() != menuMode && setDisplayMode(menuMode) == XST_SUCCESS) initSelectors();
 	drawStage();
 }
 
@@ -533,20 +1473,36 @@ void enterEcho(void) {
  *
  * @return	None.
  *
- * @note	None.
+ * @note	The lines run in the cheapest display mode that holds
+ * 			LINES_SCREEN_WIDTH x LINES_SCREEN_HEIGHT, a pixel-doubled
+ * 			one unless the DMA is in SG mode, and start over each time.
+ * 			With indexed framebuffers the colors of the lines on
+ * 			screen keep cycling through the palette, without being
+ * 			drawn again.
  *************************************************************/
 void enterLines(void) {
+	static const paletteAnimation linesCycle = {PALETTE_CYCLE, LINES_CYCLE_FIRST, LINES_CYCLE_COUNT, LINES_CYCLE_PERIOD, NULL};
+	displayModeId menuMode = getDisplayMode();
+	s32 linesMode = findDisplayMode(LINES_SCREEN_WIDTH, LINES_SCREEN_HEIGHT);
+	u32 t = 0;
+
+	if(linesMode >= 0) setDisplayMode(linesMode);
+	initializeLines();
 	drawLines();
+	//The lines are clipped below the header
+	pushClip(&screenSurface, (point) {0, LINES_TOP}, (point) {SCREEN_WIDTH - 1, SCREEN_HEIGHT - 1});
+	s32 cycle = startPaletteAnimation(&linesCycle);
 
 	do {
-		static u32 t = 0;
 		drawLinesB(t);
+		present();
 		if(t < 255) t++;
 		else t = 0;
 	} while(caughtChar != 0x1B);
 
-	clearVGA();
-	drawStage();
+	stopPaletteAnimation(cycle);
+	popClip(&screenSurface);
+	returnToMenu(menuMode);
 }
 
 /*************************************************************
@@ -570,11 +1526,21 @@ void enterExit(void) {
  *
  * @return	None.
  *
- * @note	None.
+ * @note	The game runs in the cheapest display mode that holds
+ * 			its playing field, the menu's mode is restored after.
+ * 			A pixel-doubled mode holding half the field is preferred,
+ * 			the field is drawn at half size and looks the same.
  *************************************************************/
 void enterExtras(void) {
+	displayModeId menuMode = getDisplayMode();
+	s32 snakeMode = findDisplayMode(SNAKE_SCREEN_WIDTH / 2, SNAKE_SCREEN_HEIGHT / 2);
+
+	//The playing field has a fixed layout, switch to the cheapest mode that holds it
+	if(snakeMode < 0 || displayModes[snakeMode].scale == 1) snakeMode = findDisplayMode(SNAKE_SCREEN_WIDTH, SNAKE_SCREEN_HEIGHT);
+	if(snakeMode < 0 || setDisplayMode(snakeMode) != XST_SUCCESS) return;
 	drawExtras();
 	enterSnake();
+	returnToMenu(menuMode);
 }
 
 /*************************************************************
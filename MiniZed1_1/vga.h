@@ -4,7 +4,7 @@
  *
  * Author: Ahac Rafael Bela
  * Created on: 01.03.2025
- * Last modified: 14.04.2025
+ * Last modified: 17.05.2025
  *************************************************************/
 //Protection macro
 #pragma once
@@ -15,6 +15,10 @@
 * Include section
 *************************************************************/
 #include "libs.h"
+#include "framebuffer.h"
+#include "palette.h"
+#include "display.h"
+#include "dmaqueue.h"
 #include "lines.h"
 //IBM VGA 8 by 16 pixels font
 #include "IBM_VGA_8x16.h"
@@ -23,14 +27,42 @@
 * Macro section
 *************************************************************/
 //How many bytes in vgaArray to go one pixel down
-#define PITCH 		3200
-//How many bytes in dataArray to next pixel
-#define PIXEL_WIDTH	4
+#define PITCH 		FB_PITCH
+//How many bytes in a surface n pixels take
+#define PIXEL_BYTES(n)	((n) * FB_BITS_PER_PIXEL / 8)
+//Address of row y of a surface
+#define SURFACE_ROW(s, y)	((pixel *) ((u8 *) (s)->base + (s32) (y) * (s32) (s)->pitch))
+//Smallest pitch of a surface w pixels wide, rows padded to whole words for the DMA
+#define SURFACE_PITCH(w)	(((w) * FB_BITS_PER_PIXEL + 31) / 32 * 4)
+//Number of pixels to keep for an offscreen surface of w x h pixels
+#define SURFACE_PIXELS(w, h)	((h) * SURFACE_PITCH(w) / sizeof(pixel))
+//Pixels in a byte and in a 32 bit word, the unit of DMA addresses and lengths
+#define PIXELS_PER_BYTE	(8 / FB_BITS_PER_PIXEL)
+#define PIXELS_PER_WORD	(32 / FB_BITS_PER_PIXEL)
+//Converts a color, 8 bits per channel with red in the low byte, to a pixel in FB_FORMAT,
+//or to the palette index matched to it. RGB565 keeps the high bits of each channel.
+#if FB_INDEXED
+#define COLOR_TO_PIXEL(c)	((pixel) paletteMatch[PALETTE_KEY(c)])
+#elif FB_FORMAT == FB_FORMAT_RGB565
+#define COLOR_TO_PIXEL(c) \
+	((pixel) ((((c) & 0xFF) >> 3) | ((((c) >> 8 & 0xFF) >> 2) << 5) | ((((c) >> 16 & 0xFF) >> 3) << 11)))
+#else
+#define COLOR_TO_PIXEL(c)	((pixel) ((c) & 0x00FFFFFF))
+#endif
 //How many pixels for a character
 #define CHAR_WIDTH  8
 #define CHAR_HEIGHT 16
 //How many characters per line
 #define CHARS_PER_LINE 100
+//Largest scale a character is drawn at by the two-color expand kernel, a scaled row
+//of the glyph fits the 32 bit mask up to 4
+#define CHAR_EXPAND_MAX_SCALE 4
+//Smallest box filled by the DMA, smaller boxes are faster with the CPU
+#define FILL_DMA_MIN_PIXELS 4096
+//Shortest row blitSurface copies with the DMA, shorter rows are faster with memcpy than with a DMA job each
+#define BLIT_DMA_MIN_ROW_BYTES 1024
+//Above this size flushing the whole data cache is faster than a range flush (L2 size)
+#define FILL_FLUSH_ALL_BYTES (512 * 1024)
 //Selector padding
 #define SELECTOR_PADDING 3
 //Selector is x-centered and has maximum space for 14 characters of 2x scale, so 224 pixels.
@@ -44,23 +76,25 @@
 /**************************************************************
 * Enum section
 *************************************************************/
+//The 16 colors of the VGA text modes, 8 bits per channel with red in the low byte,
+//each channel repeats its 4 bit level in both halves of its byte
 typedef enum colors {
 	black	=	0x0,
-	blue	=	0x0A0000,
-	green	=	0x000A00,
-	cyan	=	0x0A0A00,
-	red		=	0x00000A,
-	purple	=	0x0A000A,
-	brown	=	0x00050A,
-	gray	=	0x0A0A0A,
-	d_gray	=	0x050505,
-	l_blue	=	0x0F0505,
-	l_green	=	0x050F05,
-	l_cyan	=	0x0F0F05,
-	l_red	=	0x05050F,
-	l_purple=	0x0F050F,
-	yellow	=	0x050F0F,
-	white	=	0x0F0F0F
+	blue	=	0xAA0000,
+	green	=	0x00AA00,
+	cyan	=	0xAAAA00,
+	red		=	0x0000AA,
+	purple	=	0xAA00AA,
+	brown	=	0x0055AA,
+	gray	=	0xAAAAAA,
+	d_gray	=	0x555555,
+	l_blue	=	0xFF5555,
+	l_green	=	0x55FF55,
+	l_cyan	=	0xFFFF55,
+	l_red	=	0x5555FF,
+	l_purple=	0xFF55FF,
+	yellow	=	0x55FFFF,
+	white	=	0xFFFFFF
 } colors;
 
 /**************************************************************
@@ -88,22 +122,52 @@ extern int dx0, dx1, dy0, dy1;
 /**************************************************************
 * Function prototype section
 *************************************************************/
-//Clears the VGA screen.
-void clearVGA(void);
+//Sets up an offscreen surface in a buffer.
+int initSurface(surface *s, pixel *base, u32 width, u32 height, u32 pitch);
+//Clears a surface.
+void clearSurface(surface *dst);
+//Returns the clip rectangle drawing to a surface is limited to.
+rect getClip(const surface *dst);
+//Limits drawing to a surface to a rectangle, inside the clip rectangle before it.
+int pushClip(surface *dst, point pos0, point pos1);
+//Removes the clip rectangle pushed last.
+void popClip(surface *dst);
+//Fills whole rows of a surface with a color using the DMA.
+void fillRows(surface *dst, u32 y0, u32 rows, colors color);
+//Fills a rectangle with a color using the DMA.
+void fillRect(surface *dst, point pos0, point pos1, colors color);
+//Copies a surface into another one using the DMA.
+int blitSurface(surface *dst, point pos, const surface *src);
+//Waits until all DMA fills are done.
+void waitFill(void);
+//Saves the drawn screen with a DMA copy.
+int saveScreen(void);
+//Restores the saved screen with a DMA copy.
+int restoreScreen(void);
 //Draws a pixel.
-void putPixel(point pos, colors color);
+void putPixel(surface *dst, point pos, colors color);
+//Draws a horizontal run of pixels with whole word stores.
+void hspan(surface *dst, s32 y, s32 x0, s32 x1, colors color);
+//Draws a vertical run of pixels.
+void vspan(surface *dst, s32 x, s32 y0, s32 y1, colors color);
+//Combines a horizontal run of pixels with the pixels under it.
+void hspanOp(surface *dst, s32 y, s32 x0, s32 x1, colors color, rasterOp op);
+//Combines a vertical run of pixels with the pixels under it.
+void vspanOp(surface *dst, s32 x, s32 y0, s32 y1, colors color, rasterOp op);
 //Draws a character.
-void drawChar(u8 c, point pos, u32 scale, colors fgcolor, colors bgcolor);
+void drawChar(surface *dst, u8 c, point pos, u32 scale, colors fgcolor, colors bgcolor);
 //Draws a text.
-void drawText(const char* text, point textP, u32 scale, colors fgcolor, colors bgcolor);
+void drawText(surface *dst, const char* text, point textP, u32 scale, colors fgcolor, colors bgcolor);
 //Draws a straight line.
-void drawStraight(point pos0, point pos1, u32 color);
+void drawStraight(surface *dst, point pos0, point pos1, u32 color);
 //Draws a box.
-void drawBox(point pos0, point pos1, colors color);
+void drawBox(surface *dst, point pos0, point pos1, colors color);
 //Draws a filled box.
-void drawBoxFull(point pos0, point pos1, colors color);
+void drawBoxFull(surface *dst, point pos0, point pos1, colors color);
 //Draws a selector box.
-void drawSelector(point tL, colors color);
+void drawSelector(surface *dst, point tL, colors color);
+//Sets the menu coordinates for the current display mode.
+void initSelectors(void);
 //Draws the selection menu.
 void drawMenu(void);
 //Draws the starting selection menu.